@@ -0,0 +1,175 @@
+/**
+ * @brief Compares the ways of computing the world coordinates of a hierarchy.
+ *
+ * A Room is filled with Elements grouped in small trees. Every frame the top Elements move and rotate, as a room wide
+ * parallax would, and the world position of every Element is read. The time of each frame is measured for:
+ * - RECURSIVE: the original getWorldPosition(), walking up the parents of every Element through weak_ptr, reproduced
+ *   here since LocalCoords now caches its world coordinates.
+ * - CACHED: LocalCoords world coordinates cached behind dirty flags.
+ * - STORE: the hierarchy moved to a TransformStore, updated in one linear pass.
+ * - PROPAGATED/mt: Room::propagateTransforms() on every hardware thread before reading, the read time is included.
+ *   The time reported by the Room for the propagation alone is printed too.
+ *
+ * A second run has every Element move and read its own world position right after, as the Elements of a Room do on
+ * their loop(), with CACHED and STORE.
+ * @file bench_Transforms.cpp
+ */
+
+#include "GDMBasics.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+/**
+ * getWorldPosition() before world coordinates were cached, with the affine composition of the current one.
+ */
+sf::Transform recursiveWorldTransform(const mate::LocalCoords &coords)
+{
+    if (const auto spt_parent = coords.getParent().lock())
+    {
+        return recursiveWorldTransform(*spt_parent) * coords.getTransform();
+    }
+    return coords.getTransform();
+}
+
+enum Mode
+{
+    RECURSIVE,
+    CACHED,
+    STORE,
+    PROPAGATED
+};
+
+struct result
+{
+    double frame_ms;
+    double checksum;
+    double propagation_ms;
+};
+
+result runMode(const std::shared_ptr<mate::Room> &room, const std::vector<std::shared_ptr<mate::Element>> &tops,
+               const std::vector<std::shared_ptr<mate::Element>> &elements, const Mode mode, const int frames)
+{
+    room->useTransformStore(mode == STORE ? std::make_shared<mate::TransformStore>() : nullptr);
+    room->setTransformThreads(mode == PROPAGATED ? 0 : 1);
+    room->propagateTransforms();
+    for (const auto &top : tops)
+    {
+        top->setPosition(0, 0);
+        top->setRotation(0);
+    }
+
+    double checksum = 0;
+    double propagation_ms = 0;
+    std::chrono::duration<double, std::milli> elapsed{0};
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &top : tops)
+        {
+            top->move(1, 0.5f);
+            top->rotate(0.1f);
+        }
+        if (mode == PROPAGATED)
+        {
+            room->propagateTransforms();
+            propagation_ms += room->getTransformPropagationTime().asMicroseconds() / 1000.0;
+        }
+        for (const auto &element : elements)
+        {
+            const sf::Vector2f position = mode == RECURSIVE
+                                              ? recursiveWorldTransform(*element).transformPoint(0, 0)
+                                              : element->getWorldPosition();
+            checksum += position.x + position.y;
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return {elapsed.count() / frames, checksum, propagation_ms / frames};
+}
+
+/**
+ * Every Element moves and then reads its world position, in creation order.
+ */
+result runInterleaved(const std::shared_ptr<mate::Room> &room,
+                      const std::vector<std::shared_ptr<mate::Element>> &elements, const Mode mode, const int frames)
+{
+    room->useTransformStore(mode == STORE ? std::make_shared<mate::TransformStore>() : nullptr);
+    room->setTransformThreads(1);
+    room->propagateTransforms();
+
+    double checksum = 0;
+    std::chrono::duration<double, std::milli> elapsed{0};
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &element : elements)
+        {
+            element->move(0.5f, 0.25f);
+            const sf::Vector2f position = element->getWorldPosition();
+            checksum += position.x + position.y;
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    // Back to where they were, so every mode reads the same positions
+    for (const auto &element : elements)
+    {
+        element->move(-0.5f * frames, -0.25f * frames);
+    }
+    return {elapsed.count() / frames, checksum, 0};
+}
+} // namespace
+
+int main()
+{
+    const std::pair<const char *, Mode> modes[] = {
+        {"RECURSIVE", RECURSIVE}, {"CACHED", CACHED}, {"STORE", STORE}, {"PROPAGATED/mt", PROPAGATED}};
+    const std::pair<const char *, Mode> interleaved_modes[] = {{"CACHED/moved", CACHED}, {"STORE/moved", STORE}};
+
+    std::cout << std::left << std::setw(10) << "elements" << std::setw(16) << "mode" << std::setw(14) << "ms/frame"
+              << std::setw(16) << "propagation ms" << "checksum" << std::endl;
+
+    for (const int count : {1000, 10000, 50000})
+    {
+        // Trees of 50 Elements, every Element is a child of a random previous Element of its tree
+        std::mt19937 generator(count);
+        std::uniform_real_distribution<float> offset(-20, 20);
+        auto room = std::make_shared<mate::Room>();
+        std::vector<std::shared_ptr<mate::Element>> tops;
+        std::vector<std::shared_ptr<mate::Element>> elements;
+        for (int i = 0; i < count; ++i)
+        {
+            const int tree_index = i % 50;
+            if (tree_index == 0)
+            {
+                tops.push_back(room->addElement());
+                elements.push_back(tops.back());
+            }
+            else
+            {
+                std::uniform_int_distribution<int> parent(static_cast<int>(elements.size()) - tree_index,
+                                                           static_cast<int>(elements.size()) - 1);
+                elements.push_back(elements[parent(generator)]->addChild());
+            }
+            elements.back()->setPosition(offset(generator), offset(generator));
+            elements.back()->setRotation(offset(generator));
+        }
+
+        const auto print = [count](const char *name, const result &measured) {
+            std::cout << std::setw(10) << count << std::setw(16) << name << std::setw(14) << std::fixed
+                      << std::setprecision(3) << measured.frame_ms << std::setw(16) << measured.propagation_ms
+                      << std::setprecision(0) << measured.checksum << std::endl;
+        };
+        for (const auto &[name, mode] : modes)
+        {
+            print(name, runMode(room, tops, elements, mode, 20));
+        }
+        for (const auto &[name, mode] : interleaved_modes)
+        {
+            print(name, runInterleaved(room, elements, mode, 20));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @brief Compares the frame time of the Trigger broad-phases.
+ *
+ * A Room is filled with small Triggers that move a few pixels every frame and the time of room->loop() +
+ * room->renderLoop() is measured for every BroadPhaseType, and for SWEEP_AND_PRUNE using every hardware thread on the
+ * narrow-phase. BRUTE_FORCE is the original runChecks() behaviour, since it's quadratic it only runs up to 10k Triggers
+ * unless the program is called with --all.
+ * @file bench_Triggers.cpp
+ */
+
+#include "GDMBasics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+namespace
+{
+class CountTrigger : public mate::Trigger
+{
+  public:
+    explicit CountTrigger(const std::weak_ptr<mate::Element> &parent) : Trigger(parent)
+    {
+    }
+    static unsigned long count;
+
+  protected:
+    void fireTrigger(const std::shared_ptr<Trigger> &trigger_by) override
+    {
+        ++count;
+    }
+};
+
+unsigned long CountTrigger::count = 0;
+
+struct result
+{
+    double frame_ms;
+    unsigned long fired;
+};
+
+/**
+ * Every broad-phase starts from the same positions and follows the same movements, so the fired count must match.
+ */
+result runBroadPhase(const std::shared_ptr<mate::Room> &room,
+                     const std::vector<std::shared_ptr<mate::Element>> &elements,
+                     const std::vector<sf::Vector2f> &positions, mate::BroadPhaseType broad_phase, int frames)
+{
+    room->setTriggerBroadPhase(broad_phase);
+    for (std::size_t i = 0; i < elements.size(); ++i)
+    {
+        elements[i]->setPosition(positions[i]);
+    }
+
+    std::mt19937 generator(1);
+    std::uniform_real_distribution<float> step(-2, 2);
+
+    // Warm up frame, builds the broad-phase structures
+    room->loop();
+    room->renderLoop();
+
+    CountTrigger::count = 0;
+    std::chrono::duration<double, std::milli> elapsed{0};
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        for (const auto &element : elements)
+        {
+            element->move(step(generator), step(generator));
+        }
+        const auto start = std::chrono::steady_clock::now();
+        room->loop();
+        room->renderLoop();
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+    return {elapsed.count() / frames, CountTrigger::count / frames};
+}
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const bool run_all = argc > 1 && std::strcmp(argv[1], "--all") == 0;
+    const std::pair<const char *, mate::BroadPhaseType> broad_phases[] = {{"BRUTE_FORCE", mate::BRUTE_FORCE},
+                                                                          {"SPATIAL_HASH", mate::SPATIAL_HASH},
+                                                                          {"DYNAMIC_TREE", mate::DYNAMIC_TREE},
+                                                                          {"SWEEP_AND_PRUNE", mate::SWEEP_AND_PRUNE}};
+
+    std::cout << std::left << std::setw(10) << "triggers" << std::setw(20) << "broad-phase" << std::setw(14)
+              << "ms/frame" << "fired/frame" << std::endl;
+
+    for (const int count : {1000, 10000, 50000})
+    {
+        // Keeps the same density for every count, around 40x40 units per Trigger
+        const float side = std::sqrt(static_cast<float>(count)) * 40;
+        std::mt19937 generator(count);
+        std::uniform_real_distribution<float> position(0, side);
+        std::uniform_real_distribution<float> size(4, 32);
+
+        auto room = std::make_shared<mate::Room>();
+        std::vector<std::shared_ptr<mate::Element>> elements;
+        std::vector<sf::Vector2f> positions;
+        for (int i = 0; i < count; ++i)
+        {
+            auto element = room->addElement();
+            positions.emplace_back(position(generator), position(generator));
+            auto trigger = element->addComponent<CountTrigger>();
+            trigger->setDimensions(size(generator), size(generator));
+            trigger->setShape(i % 10 == 0 ? mate::CIRCLE : mate::RECTANGLE);
+            trigger->subscribe();
+            elements.push_back(element);
+        }
+
+        for (const auto &[name, broad_phase] : broad_phases)
+        {
+            if (broad_phase == mate::BRUTE_FORCE && count > 10000 && !run_all)
+            {
+                std::cout << std::setw(10) << count << std::setw(20) << name << "skipped (use --all)" << std::endl;
+                continue;
+            }
+            // The pair count overflows an int at 50k Triggers
+            const auto pairs = static_cast<std::int64_t>(count) * count / 2;
+            const int frames = broad_phase == mate::BRUTE_FORCE
+                                   ? static_cast<int>(std::clamp<std::int64_t>(20000000 / pairs, 1, 20))
+                                   : 20;
+            const auto [frame_ms, fired] = runBroadPhase(room, elements, positions, broad_phase, frames);
+            std::cout << std::setw(10) << count << std::setw(20) << name << std::setw(14) << std::fixed
+                      << std::setprecision(3) << frame_ms << fired << std::endl;
+        }
+
+        // Narrow-phase split across all the hardware threads
+        room->setTriggerThreads(0);
+        const auto [frame_ms, fired] = runBroadPhase(room, elements, positions, mate::SWEEP_AND_PRUNE, 20);
+        room->setTriggerThreads(1);
+        std::cout << std::setw(10) << count << std::setw(20) << "SWEEP_AND_PRUNE/mt" << std::setw(14) << std::fixed
+                  << std::setprecision(3) << frame_ms << fired << std::endl;
+    }
+    return 0;
+}
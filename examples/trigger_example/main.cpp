@@ -62,6 +62,18 @@ namespace mate
 		}
 	};
 
+	/*
+	 * Triggers can be placed on up to 32 layers, every Trigger has a category (the layers it belongs to) and a
+	 * collision mask (the layers it can be superposed with). Two Triggers are only checked when the category of each
+	 * one matches the mask of the other, every other pair is discarded before even calculating their positions.
+	 */
+	enum Layers : std::uint32_t
+	{
+		PLAYER_LAYER = 1 << 0,
+		PICKUP_LAYER = 1 << 1,
+		HAZARD_LAYER = 1 << 2
+	};
+
 	game_instance start()
 	{
 		/*
@@ -101,6 +113,11 @@ namespace mate
 		 */
 		player_trigger->setDimensions(64, 64);
 		player_trigger->setShape(CIRCLE);
+		/*
+		 * The player belongs to the player layer and, at the beginning, it only reacts to pickups.
+		 */
+		player_trigger->setCategory(PLAYER_LAYER);
+		player_trigger->setCollisionMask(PICKUP_LAYER);
 
 		/*
 		 * Now we are going to add some extra Triggers that will change the player's color when fired.
@@ -150,6 +167,17 @@ namespace mate
 		trigger_circle->setColor(sf::Color::Yellow);
 		trigger_circle->addSprite(sprite); // This will turn the player's sprite yellow on contact
 
+		/*
+		 * Both squares are pickups, while the circle is a hazard. Since the player's mask doesn't include the hazard
+		 * layer the circle will be ignored until the H key is pressed (see the end of this function).
+		 */
+		trigger_square_one->setCategory(PICKUP_LAYER);
+		trigger_square_one->setCollisionMask(PLAYER_LAYER);
+		trigger_square_two->setCategory(PICKUP_LAYER);
+		trigger_square_two->setCollisionMask(PLAYER_LAYER);
+		trigger_circle->setCategory(HAZARD_LAYER);
+		trigger_circle->setCollisionMask(PLAYER_LAYER);
+
 		/*
 		 * To enable a trigger you must call it's subscribe method, to unable it you can call it's unsubscribe method.
 		 * Triggers are disabled by default so make sure you enable all of them before you return from this function.
@@ -174,6 +202,13 @@ namespace mate
 		// std::static_pointer_cast<typename std::remove_pointer<decltype(obj.get())>::type>(obj);
 		const auto aux_pointer = std::static_pointer_cast<Trigger>(player_trigger);
 		inputs->addInput(sf::Keyboard::Key::Space, &Trigger::switchActive, aux_pointer);
+		/*
+		 * And the H and P keys to start or stop reacting to the hazard layer.
+		 */
+		inputs->addInput(sf::Keyboard::Key::H, &Trigger::setCollisionMask, aux_pointer,
+		                 static_cast<std::uint32_t>(PICKUP_LAYER | HAZARD_LAYER));
+		inputs->addInput(sf::Keyboard::Key::P, &Trigger::setCollisionMask, aux_pointer,
+		                 static_cast<std::uint32_t>(PICKUP_LAYER));
         return game;
     }
 }
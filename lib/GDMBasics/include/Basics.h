@@ -4,8 +4,16 @@
  * @file Basics.h
  */
 
+#include "ComponentStorage.h"
 #include "LocalCoords.h"
+#include "RoomArena.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
 #include <list>
+#include <mutex>
+#include <vector>
 
 #ifndef GDMBUILDALL_BASICS_H
 #define GDMBUILDALL_BASICS_H
@@ -14,6 +22,13 @@ namespace mate
 {
 class Element;
 class Component;
+class Room;
+class CommandBuffer;
+class JobSystem;
+class Trigger;
+class ElementPool;
+class Game;
+struct trigger_world;
 
 /**
  * @brief sf::Sprite but with an additional depth value for better ordering
@@ -35,6 +50,17 @@ struct ord_sprite
     }
 };
 
+/**
+ * @brief Stand-in for the window of a headless Game. Nothing is displayed, it only keeps the window state so Cameras
+ * keep working.
+ */
+struct null_window
+{
+    sf::View view;
+    sf::Vector2i position;
+    sf::Vector2u size;
+};
+
 /**
  * @brief Struct to asociate a unique ID value to all sf::RenderWindow.
  * This allows for better tracking of game windows.
@@ -44,17 +70,12 @@ struct render_target
     // Todo: Use an sf::RenderTarget instead of an sf::RenderWindow
     // The target contains the dimensions of the window where the  sprites will be printed
     std::unique_ptr<sf::RenderWindow> target{};
-    const u_int id;
-
-    render_target() : id(generate_id())
-    {
-    }
+    std::unique_ptr<null_window> headless{}; ///< Used instead of target by headless Games.
+    std::size_t draw_calls = 0;              ///< Sprites drawn since the target was last cleared.
+    const u_int id;                          ///< Unique on its Game, 0 for the main target.
 
-  private:
-    static int generate_id()
+    explicit render_target(u_int id_) : id(id_)
     {
-        static int unique_id = 0;
-        return unique_id++;
     }
 };
 
@@ -88,6 +109,15 @@ class IDestroy
     }
 };
 
+/**
+ * @brief How a Game presents its Rooms, chosen when the Game is created.
+ */
+enum GameMode
+{
+    WINDOWED, ///< Renders on windows and handles their events.
+    HEADLESS  ///< No windows or events, draws are only counted. Every frame simulates one step as fast as possible.
+};
+
 /**
  * @brief Interface. Defines all the "loop" and "event" methods for the building blocks of the game.
  *
@@ -121,6 +151,29 @@ class ILoop
      * This method is meant for visual's corrections based on window resizing.
      */
     virtual void windowResizeEvent(){};
+
+    /**
+     * @return simulated time advanced by the current loop(), the fixed step of the Game. Set by Room::loop() on the
+     * threads running it, jobs spawned by a loop() should be given the value.
+     */
+    [[nodiscard]] static sf::Time getDeltaTime()
+    {
+        return current_delta_time;
+    }
+
+    /**
+     * @return on renderLoop(), how far the rendered frame is between the last simulated tick and the next one, from 0
+     * to 1. Drawing objects between their last two states by this fraction keeps the motion smooth when the framerate
+     * doesn't match the fixed step. 1 outside of the Game's frames.
+     */
+    [[nodiscard]] static float getInterpolation()
+    {
+        return current_interpolation;
+    }
+
+  protected:
+    static thread_local sf::Time current_delta_time;
+    static thread_local float current_interpolation;
 };
 
 /**
@@ -132,6 +185,9 @@ class ILowLoop : public IDestroy, public ILoop
 {
 };
 
+/// List of ILowLoop children, with its nodes on the RoomArena of their Room.
+using low_loop_list = std::list<std::shared_ptr<ILowLoop>, ArenaAllocator<std::shared_ptr<ILowLoop>>>;
+
 /**
  * Verifies if a Component implementation has a constructor that takes as it's only parameter an Element.
  * @tparam T Class that inherits from Component.
@@ -140,20 +196,167 @@ template <class T>
 concept valid_component =
     std::is_base_of_v<Component, T> && requires(std::weak_ptr<Element> element) { T{element}; };
 
+/**
+ * Components that can be kept on the ComponentTable of their Room, they declare it with a static constexpr bool
+ * component_system = true. Their loop methods must work when called once per type for the whole Room, instead of in
+ * the order of the children of their Element.
+ * @tparam T Class that inherits from Component.
+ */
+template <class T>
+concept system_component = valid_component<T> && requires { requires T::component_system; };
+
+/**
+ * Threads a Component's loop() can run on when the Room loops its Elements in parallel, see Room::setLoopThreads().
+ */
+enum ThreadAffinity
+{
+    MAIN_THREAD, ///< Default, the Element holding the Component and its whole top Element run on the main thread.
+    ANY_THREAD   ///< loop() only touches the Component, its Element's subtree and thread safe objects.
+};
+
+/**
+ * Components whose loop() can run on any thread, they declare it with a static constexpr ThreadAffinity
+ * thread_affinity = ANY_THREAD. Structural changes from their loop() must be recorded on the CommandBuffer.
+ * @tparam T Class that inherits from Component.
+ */
+template <class T>
+concept any_thread_component = valid_component<T> && requires { requires T::thread_affinity == ANY_THREAD; };
+
 /**
  * @brief Abstract class for the implementation of special Element functionalities.
  */
 class Component : public ILowLoop
 {
+  private:
+    object_handle _handle = handles().add(this);
+    bool _sleeping = false;
+
+  public:
+    /**
+     * Marks the Component for destruction and asks its Element to remove it on its next loop().
+     */
+    void destroy() override;
+
+  private:
+
+    /**
+     * @return table of every existing Component.
+     */
+    static HandleTable<Component> &handles()
+    {
+        // Never destroyed, static objects like the Game may still hold objects when the program exits
+        static auto *table = new HandleTable<Component>();
+        return *table;
+    }
+
   public:
     explicit Component(std::weak_ptr<LocalCoords> parent) : _parent(std::move(parent))
     {
+        if (const auto spt_parent = _parent.lock())
+        {
+            _parent_handle = spt_parent->getHandle();
+        }
+    }
+
+    /// The handle is tied to the object's address.
+    Component(const Component &) = delete;
+    Component &operator=(const Component &) = delete;
+
+    ~Component()
+    {
+        handles().remove(_handle);
+    }
+
+    /**
+     * @return handle of the Component, fails once the Component is destroyed.
+     */
+    [[nodiscard]] object_handle getHandle() const
+    {
+        return _handle;
+    }
+
+    /**
+     * @return Component referenced by handle, nullptr if it was destroyed. O(1) and without reference counts.
+     */
+    static Component *fromHandle(object_handle handle)
+    {
+        return handles().get(handle);
+    }
+
+    /**
+     * @return true while the Element of the Component waits on its ElementPool.
+     */
+    [[nodiscard]] bool isSleeping() const
+    {
+        return _sleeping;
+    }
+
+    /**
+     * Executed when the world coordinates of the Element of the Component change, because the Element or one of its
+     * ancestors moved. Only called on the Components that override it, once until the coordinates are read again.
+     * Runs inside the setter that moved them, so it must stay cheap.
+     */
+    virtual void onParentMoved()
+    {
+    }
+
+    /**
+     * Puts the Component to sleep or wakes it up, calling onSleep() or onWake(). Used by Element::sleep() and
+     * Element::wake().
+     */
+    void setSleeping(bool sleeping)
+    {
+        if (_sleeping == sleeping)
+        {
+            return;
+        }
+        _sleeping = sleeping;
+        if (sleeping)
+        {
+            onSleep();
+        }
+        else
+        {
+            onWake();
+        }
     }
 
   protected:
+    /**
+     * Executed when the Element of the Component goes back to its ElementPool. Components with effects outside
+     * their Element's loops should pause them here.
+     */
+    virtual void onSleep()
+    {
+    }
+
+    /**
+     * Executed when the Element of the Component is spawned again by its ElementPool, before the reset hook.
+     */
+    virtual void onWake()
+    {
+    }
+
     std::weak_ptr<LocalCoords> _parent; ///< Element that contains the Component and controls it's destruction.
+    object_handle _parent_handle;       ///< Same as _parent, used by the Components themselves.
+
+    /**
+     * @return the Element that contains the Component, nullptr if it doesn't exist. Doesn't touch reference counts.
+     */
+    [[nodiscard]] LocalCoords *getParentCoords() const
+    {
+        return LocalCoords::fromHandle(_parent_handle);
+    }
 };
 
+/**
+ * Verifies if T overrides Component::onParentMoved(), see overrides_render_loop.
+ * @tparam T Class that inherits from Component.
+ */
+template <class T>
+concept overrides_parent_moved =
+    !requires { requires std::is_same_v<decltype(&T::onParentMoved), void (Component::*)()>; };
+
 /**
  * @brief Main game entity.
  *
@@ -165,7 +368,67 @@ class Component : public ILowLoop
 class Element : public mate::LocalCoords, public ILowLoop
 {
   private:
-    std::list<std::shared_ptr<ILowLoop>> _children;
+    std::shared_ptr<RoomArena> _arena; ///< Pools of the Room, the children and Components are allocated there.
+    low_loop_list _children;
+    // Children visited on each phase, owned by _children. Elements are on both, Components only if they override it
+    std::vector<ILowLoop *> _render_loops;
+    std::vector<ILowLoop *> _resize_loops;
+    std::vector<ILowLoop *> _main_thread_loops; ///< Components without any_thread_component, owned by _children.
+    std::vector<Component *> _move_listeners;   ///< Components with overrides_parent_moved, not owned.
+    /// Components on the ComponentStorage of the Room, owned here but run by the Room.
+    low_loop_list _stored_components;
+    /// Components of the Element indexed by componentTypeId(), in creation order.
+    std::vector<std::vector<std::shared_ptr<Component>>> _components_by_type;
+    std::size_t _indexed_components = 0;
+
+    unsigned long _elements_count = 0;      ///< Children Elements.
+    unsigned long _full_elements_count = 0; ///< Every Element under the Element's authority.
+    unsigned long _main_thread_count = 0;   ///< MAIN_THREAD Components of the Element and every Element under it.
+    object_handle _owner_handle;            ///< Element holding this one as a child, empty for top Elements.
+    object_handle _owner_room_handle;       ///< Room holding this one on its loops, empty for children Elements.
+    std::weak_ptr<ElementPool> _pool;       ///< Pool the Element goes back to when destroyed.
+    bool _purge_pending = false;            ///< A child was destroyed, the next loop() removes it.
+
+    /**
+     * @return Room at the root of the Element's hierarchy, nullptr if the hierarchy doesn't end on a Room.
+     */
+    [[nodiscard]] Room *findRoom() const;
+
+    /**
+     * Adds the deltas to the full Elements and MAIN_THREAD counts of the Element and of every Element above it.
+     */
+    void changeSubtreeCounts(long elements, long main_thread_components);
+
+    /**
+     * Updates the counters for a child that's about to be removed.
+     */
+    void releaseChild(const std::shared_ptr<ILowLoop> &child);
+
+    /**
+     * Removes the Components marked for destruction from the type index.
+     */
+    void purgeComponentIndex();
+
+    void indexComponent(std::size_t type, std::shared_ptr<Component> component)
+    {
+        if (type >= _components_by_type.size())
+        {
+            _components_by_type.resize(type + 1);
+        }
+        _components_by_type[type].push_back(std::move(component));
+        ++_indexed_components;
+    }
+
+    /**
+     * @return storage of the Room at the root of the Element's hierarchy, nullptr if it doesn't use one.
+     */
+    [[nodiscard]] ComponentStorage *findComponentStorage() const;
+
+  protected:
+    /**
+     * Calls onParentMoved() on the Components that override it.
+     */
+    void onWorldInvalidated() override;
 
   public:
     // Constructors
@@ -199,20 +462,114 @@ class Element : public mate::LocalCoords, public ILowLoop
      */
     Element() = default;
 
-    [[maybe_unused]] unsigned long getElementsCount() const;
+    /**
+     * @return amount of children Elements. O(1), the count is kept up to date as children are added and purged.
+     */
+    [[maybe_unused]] unsigned long getElementsCount() const
+    {
+        return _elements_count;
+    }
+
+    /**
+     * @return MAIN_THREAD Components run by the Element and every Element under it. Room::loop() only sends the top
+     * Elements without any to other threads.
+     */
+    [[nodiscard]] unsigned long getMainThreadComponentsCount() const
+    {
+        return _main_thread_count;
+    }
+
+    /**
+     * @brief First Component of exactly type T added to the Element.
+     *
+     * The lookup is an index by componentTypeId<T>(), without RTTI. Only the exact type is matched, a Component of a
+     * class derived from T is found by asking for the derived class. Components marked for destruction are found
+     * until they are purged on the next loop().
+     * @return the Component, nullptr if the Element has none of type T.
+     */
+    template <valid_component T> [[nodiscard]] std::shared_ptr<T> getComponent() const
+    {
+        const std::size_t type = componentTypeId<T>();
+        if (type < _components_by_type.size() && !_components_by_type[type].empty())
+        {
+            return std::static_pointer_cast<T>(_components_by_type[type].front());
+        }
+        return nullptr;
+    }
+
+    /**
+     * @return every Component of exactly type T on the Element, in creation order. See getComponent().
+     */
+    template <valid_component T> [[nodiscard]] std::vector<std::shared_ptr<T>> getComponents() const
+    {
+        std::vector<std::shared_ptr<T>> components;
+        const std::size_t type = componentTypeId<T>();
+        if (type < _components_by_type.size())
+        {
+            components.reserve(_components_by_type[type].size());
+            for (const auto &component : _components_by_type[type])
+            {
+                components.push_back(std::static_pointer_cast<T>(component));
+            }
+        }
+        return components;
+    }
+
+    /**
+     * @return true if the Element has a Component of exactly type T. See getComponent().
+     */
+    template <valid_component T> [[nodiscard]] bool hasComponent() const
+    {
+        const std::size_t type = componentTypeId<T>();
+        return type < _components_by_type.size() && !_components_by_type[type].empty();
+    }
 
     // Adds a new Component of the template type to the component list and returns it
     /**
      * @brief Generates a new Component.
      *
      * The Component is of the specified class and the parent of the Component is set as the calling Element instance.
+     * system_component types are placed on the table of their type when the Room uses a ComponentStorage.
      * @tparam T Component implementation that complies with valid_component
      * @return Reference to the generated Component.
      */
     template <valid_component T> std::shared_ptr<T> addComponent() noexcept
     {
-        auto new_component = std::make_shared<T>(std::dynamic_pointer_cast<Element>(shared_from_this()));
+        auto self = std::dynamic_pointer_cast<Element>(shared_from_this());
+        if constexpr (system_component<T>)
+        {
+            if (ComponentStorage *storage = findComponentStorage())
+            {
+                auto new_component = storage->getTable<T>().create(std::weak_ptr<Element>(self));
+                _stored_components.emplace_back(new_component);
+                if constexpr (overrides_parent_moved<T>)
+                {
+                    _move_listeners.push_back(new_component.get());
+                }
+                indexComponent(componentTypeId<T>(), new_component);
+                return new_component;
+            }
+        }
+        auto new_component = std::allocate_shared<T>(ArenaAllocator<T>(_arena), self);
         _children.emplace_back(new_component);
+        if constexpr (!any_thread_component<T>)
+        {
+            _main_thread_loops.push_back(new_component.get());
+            changeSubtreeCounts(0, 1);
+        }
+        if constexpr (overrides_render_loop<T>)
+        {
+            _render_loops.push_back(new_component.get());
+        }
+        if constexpr (overrides_window_resize_event<T>)
+        {
+            _resize_loops.push_back(new_component.get());
+        }
+        if constexpr (overrides_parent_moved<T>)
+        {
+            _move_listeners.push_back(new_component.get());
+        }
+        indexComponent(componentTypeId<T>(), new_component);
         return new_component;
     }
 
@@ -222,6 +579,86 @@ class Element : public mate::LocalCoords, public ILowLoop
      * @return A reference to the new Element.
      */
     std::shared_ptr<Element> addChild();
+
+    /**
+     * @brief Allocates the children and Components added afterwards on arena.
+     *
+     * Called by Room::addElement() and addChild(), so every Element under a Room shares its pools. The current
+     * children are kept, only the nodes of the lists are moved to the arena.
+     * @param arena pools to use, nullptr to use the global operator new.
+     */
+    void useArena(const std::shared_ptr<RoomArena> &arena);
+
+    /**
+     * Records the Room holding the Element on its loops, it's told when the Element is destroyed. Set by
+     * Room::addElement().
+     */
+    void setOwnerRoom(const Room &room);
+
+    /**
+     * Makes the next loop() remove the children and Components marked for destruction. Called by them when destroyed,
+     * so the Elements without destroyed children skip the removal.
+     */
+    void requestPurge()
+    {
+        _purge_pending = true;
+    }
+
+    /**
+     * @brief Removes the children and Components marked for destruction right away.
+     *
+     * Called by loop() when a purge is pending. An Element looping inside a job records it on the CommandBuffer of its
+     * Room instead, the nodes of its lists are freed on the RoomArena, which isn't synchronized.
+     */
+    void purge();
+
+    /**
+     * @return command buffer of the Room at the root of the Element's hierarchy, nullptr if there is none. See
+     * CommandBuffer.
+     */
+    [[nodiscard]] CommandBuffer *getCommands() const;
+
+    /**
+     * @return pool the Element belongs to, empty if it isn't pooled.
+     */
+    [[nodiscard]] std::weak_ptr<ElementPool> getPool() const
+    {
+        return _pool;
+    }
+
+    /**
+     * @brief Makes the Element go back to pool when destroyed, see ElementPool.
+     *
+     * Set by ElementPool on the Elements it builds.
+     */
+    void setPool(const std::weak_ptr<ElementPool> &pool)
+    {
+        _pool = pool;
+    }
+
+    /**
+     * @return true if the Element belongs to a pool that still exists.
+     */
+    [[nodiscard]] bool isPooled() const
+    {
+        return !_pool.expired();
+    }
+
+    /**
+     * Puts every Component of the Element and its children to sleep, see Component::setSleeping().
+     */
+    void sleep();
+
+    /**
+     * Clears the destruction mark and wakes up every Component of the Element and its children.
+     */
+    void wake();
+
+    [[nodiscard]] const std::shared_ptr<RoomArena> &getArena() const
+    {
+        return _arena;
+    }
+
     /**
      * @brief Marks the Element for destruction.
      *
@@ -232,6 +669,9 @@ class Element : public mate::LocalCoords, public ILowLoop
      * should be added as the first Component of an Element for efficiency. If an Element mark's it's parent for removal
      * all other children object's loop() method will be called yet those are expected to run Component and Element
      * purging only to avoid any possible unintended persistence.
+     *
+     * Pooled Elements are only marked, their children and Components are kept so the Room can give them back to
+     * their ElementPool.
      */
     void destroy() override;
     /**
@@ -240,24 +680,169 @@ class Element : public mate::LocalCoords, public ILowLoop
      * The loop() method of the children Elements and Component objects are called. The order is Components first
      * Elements second, so if an Element mark's itself or one of it's children for destruction via a Component, there
      * won't be unnecessary loop() calls performed. If the element is marked for removal it will destroy all of it's
-     * children Elements and Component objects.
+     * children Elements and Component objects. The children lists are only swept after a child asked for it with
+     * requestPurge().
      */
     void loop() override;
     /**
      * @brief Secondary loop method, meant for visual changes only.
      *
      * renderLoop() does not perform checks for an Element destruction, therefore Element destruction should only be
-     * performed on the loop() methods.
+     * performed on the loop() methods. Only the children Elements and the Components that override renderLoop() are
+     * visited, once each, in the order they were added.
      */
     void renderLoop() override;
     /**
      * @brief Communicates to all the children and Components that a window has changed in size.
+     *
+     * Same as renderLoop(), only the Components that override windowResizeEvent() are visited.
      */
     void windowResizeEvent() override;
     /**
-     * @return All the related Element under it's authority (children + children's children + etc).
+     * @return All the related Element under it's authority (children + children's children + etc). O(1), see
+     * getElementsCount().
+     */
+    [[maybe_unused]] unsigned long getFullElementsCount() const
+    {
+        return _full_elements_count;
+    }
+};
+
+/**
+ * @brief Structural changes recorded during a frame and applied together at the end of Room::loop().
+ *
+ * Adding, moving or destroying Elements and Components from a loop() changes the lists being iterated. Recording
+ * them instead leaves the hierarchy untouched until the Room reaches its sync point, after the loop() of every
+ * Element. Commands are applied in the order they were recorded. Commands recorded while applying, for example by a
+ * setup hook, are applied on the same sync point. Recording is synchronized, apply() must run on one thread.
+ */
+class CommandBuffer
+{
+  public:
+    /// Called with the new Element once it's added.
+    using element_hook = std::function<void(const std::shared_ptr<Element> &)>;
+
+    /**
+     * Records Room::addElement() on the Room applying the buffer.
+     */
+    void addElement(element_hook setup = {});
+
+    /**
+     * Records Element::addChild(), skipped if parent is gone or marked for destruction by then.
+     */
+    void addChild(const std::weak_ptr<Element> &parent, element_hook setup = {});
+
+    /**
+     * Records Element::addComponent(), skipped if element is gone or marked for destruction by then.
+     * @param setup called with the new Component once it's added.
+     */
+    template <valid_component T>
+    void addComponent(const std::weak_ptr<Element> &element,
+                      std::function<void(const std::shared_ptr<T> &)> setup = {})
+    {
+        record([element, setup = std::move(setup)](Room &) {
+            if (const auto spt_element = element.lock(); spt_element && !spt_element->shouldDestroy())
+            {
+                auto component = spt_element->addComponent<T>();
+                if (setup)
+                {
+                    setup(component);
+                }
+            }
+        });
+    }
+
+    /**
+     * Records LocalCoords::setParent(), skipped if coords is gone by then.
+     */
+    void setParent(const std::weak_ptr<LocalCoords> &coords, const std::weak_ptr<LocalCoords> &parent);
+
+    /**
+     * Records IDestroy::destroy(), skipped if object is gone by then.
+     */
+    void destroy(const std::weak_ptr<IDestroy> &object);
+
+    /**
+     * Records Element::purge(), skipped if element is gone by then.
+     */
+    void purge(const std::weak_ptr<Element> &element);
+
+    /**
+     * Applies and clears every recorded command.
+     * @param room Room receiving the addElement() commands.
+     * @return amount of commands applied.
      */
-    [[maybe_unused]] unsigned long getFullElementsCount();
+    std::size_t apply(Room &room);
+
+    /**
+     * @return amount of commands waiting for the next apply().
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        std::lock_guard lock(_mutex);
+        return _commands.size();
+    }
+
+  private:
+    mutable std::mutex _mutex;
+    std::vector<std::function<void(Room &)>> _commands;
+
+    void record(std::function<void(Room &)> command)
+    {
+        std::lock_guard lock(_mutex);
+        _commands.push_back(std::move(command));
+    }
+};
+
+/**
+ * Broad-phase algorithms available for Trigger superposition checks.
+ */
+enum BroadPhaseType
+{
+    BRUTE_FORCE,  ///< Every active Trigger is tested against every other one. Kept as the reference implementation.
+    SPATIAL_HASH,   ///< Only Triggers sharing a cell of a uniform grid are tested.
+    DYNAMIC_TREE,   ///< Only Triggers whose leaves overlap on a bounding volume hierarchy are tested.
+    SWEEP_AND_PRUNE ///< Only Triggers overlapping on the horizontal axis (and optionally the vertical) are tested.
+};
+
+/**
+ * @brief Per Room configuration of the Trigger superposition checks.
+ */
+struct trigger_settings
+{
+    /// BRUTE_FORCE by default, the accelerated broad-phases are opted in per Room with setTriggerBroadPhase().
+    BroadPhaseType broad_phase = BRUTE_FORCE;
+    float cell_size = 64.0f; ///< Side of the SPATIAL_HASH cells, ideally close to the size of the common Triggers.
+    /// Margin added around the DYNAMIC_TREE leaves. Triggers that move less than this don't change the tree.
+    float fat_margin = 4.0f;
+    /// SWEEP_AND_PRUNE also rejects the pairs that don't overlap on the vertical axis.
+    bool sweep_second_axis = true;
+    /// Threads used by the narrow-phase of the accelerated broad-phases, including the main one.
+    unsigned int worker_threads = 1;
+
+    bool operator==(const trigger_settings &) const = default;
+};
+
+/**
+ * @brief Stable identifier of a Trigger subscription, see Room::findTrigger().
+ *
+ * Handles stay valid until the Trigger unsubscribes, the generation makes old handles fail even if their proxy was
+ * given to another Trigger.
+ */
+struct trigger_handle
+{
+    int proxy = -1;
+    std::uint32_t generation = 0;
+};
+
+/**
+ * @brief Trigger hit by a ray, see Room::raycast().
+ */
+struct raycast_hit
+{
+    std::shared_ptr<Trigger> trigger;
+    float distance = 0; ///< From the origin of the ray to point, 0 if the ray starts inside the Trigger.
+    sf::Vector2f point; ///< First point of the Trigger's shape touched by the ray.
 };
 
 /**
@@ -271,12 +856,304 @@ class Element : public mate::LocalCoords, public ILowLoop
 class Room : public mate::LocalCoords, public ILoop
 {
   private:
-    std::list<std::shared_ptr<ILowLoop>> _children_loops; ///< Elements within the Room.
+    /// Pools of every Element and Component created under the Room, freed once all of them are gone.
+    std::shared_ptr<RoomArena> _arena = std::make_shared<RoomArena>();
+    low_loop_list _children_loops{ArenaAllocator<std::shared_ptr<ILowLoop>>(_arena)}; ///< Elements within the Room.
+    trigger_settings _trigger_settings;
+    std::shared_ptr<trigger_world> _trigger_world; ///< Created when the first Trigger of the Room subscribes.
+    std::shared_ptr<ComponentStorage> _component_storage;
+    CommandBuffer _commands;
+    std::atomic<bool> _purge_pending = false; ///< An Element was destroyed, the next loop() removes it.
+    std::weak_ptr<Game> _game;                ///< Game holding the Room, set by Game::addRoom().
+
+    sf::Time _delta_time = sf::seconds(1.f / 60); ///< Simulated time of every loop().
+    float _interpolation = 1;                      ///< Given to the renderLoop() of the Room's objects.
+
+    unsigned int _loop_threads = 1;
+    std::shared_ptr<JobSystem> _jobs;           ///< Created on the first call to getJobSystem().
+    std::vector<ILowLoop *> _parallel_loops;    ///< Top Elements sent to other threads on the current loop().
+    std::vector<ILowLoop *> _sequential_loops;  ///< Top Elements with MAIN_THREAD Components.
+
+    /**
+     * Runs the loop of the top Elements without MAIN_THREAD Components on the JobSystem, then the rest in order on
+     * the calling thread.
+     */
+    void loopElementsParallel();
+
+    unsigned int _transform_threads = 1;
+    std::size_t _transform_parallel_threshold = 4096;
+    std::shared_ptr<WorkerPool> _transform_pool; ///< Created on the first parallel propagation.
+    std::size_t _transform_tree_size = 0;        ///< Objects updated by the last propagation.
+    sf::Time _transform_propagation_time;
+
+    /**
+     * Same as raycastAll(), keeping only the closest hit when first_only is set.
+     */
+    std::size_t castRay(sf::Vector2f origin, sf::Vector2f direction, float max_distance,
+                        std::vector<raycast_hit> &hits, std::uint32_t mask, bool first_only);
 
   public:
     // Constructors
     Room() = default;
 
+    // Simple methods
+    [[nodiscard]] const trigger_settings &getTriggerSettings() const
+    {
+        return _trigger_settings;
+    }
+
+    /**
+     * Selects the broad-phase used for the Triggers under this Room. BRUTE_FORCE, the default, is meant as a
+     * reference to verify the results of the faster methods, which fire the same Triggers on the same order.
+     */
+    [[maybe_unused]] void setTriggerBroadPhase(BroadPhaseType broad_phase)
+    {
+        _trigger_settings.broad_phase = broad_phase;
+    }
+
+    /**
+     * @param fat_margin margin around the DYNAMIC_TREE leaves in world units, negative values are ignored.
+     */
+    [[maybe_unused]] void setTriggerFatMargin(float fat_margin)
+    {
+        if (fat_margin >= 0)
+        {
+            _trigger_settings.fat_margin = fat_margin;
+        }
+    }
+
+    /**
+     * @param second_axis if true SWEEP_AND_PRUNE only reports Triggers overlapping on both axis, otherwise overlapping
+     * on the horizontal axis is enough to reach the exact superposition checks.
+     */
+    [[maybe_unused]] void setTriggerSweepSecondAxis(bool second_axis)
+    {
+        _trigger_settings.sweep_second_axis = second_axis;
+    }
+
+    /**
+     * @param cell_size side of the SPATIAL_HASH cells in world units, non positive values are ignored.
+     */
+    [[maybe_unused]] void setTriggerCellSize(float cell_size)
+    {
+        if (cell_size > 0)
+        {
+            _trigger_settings.cell_size = cell_size;
+        }
+    }
+
+    /**
+     * The superposition tests of the accelerated broad-phases can be split across several threads, fireTrigger is
+     * still called from the main thread and on the same order as with a single thread.
+     * @param worker_threads threads to use including the main one, 0 uses one per hardware thread.
+     */
+    [[maybe_unused]] void setTriggerThreads(unsigned int worker_threads)
+    {
+        _trigger_settings.worker_threads = worker_threads;
+    }
+
+    /**
+     * @brief Keeps the system_component types (Sprite, Trigger, InputActions) of the Room on contiguous tables.
+     *
+     * Components added afterwards to Elements under the Room are built on the table of their type, and instead of
+     * being run by their Element every table is run by the Room in one pass: loop() runs the tables before the
+     * Elements, renderLoop() and windowResizeEvent() after them. Components keep the table of the Room they were
+     * created on. Components added before the call are not moved.
+     */
+    [[maybe_unused]] void useComponentStorage()
+    {
+        if (!_component_storage)
+        {
+            _component_storage = std::make_shared<ComponentStorage>();
+        }
+    }
+
+    /**
+     * @return storage of the Room, nullptr if it doesn't use one.
+     */
+    [[nodiscard]] ComponentStorage *getComponentStorage() const
+    {
+        return _component_storage.get();
+    }
+
+    /**
+     * Sets the time simulated by every loop(), read by the Room's objects with ILoop::getDeltaTime(). Set by the Game
+     * to its fixed step before every tick, 1/60 of a second by default.
+     */
+    [[maybe_unused]] void setDeltaTime(sf::Time delta_time)
+    {
+        _delta_time = delta_time;
+    }
+
+    [[nodiscard]] sf::Time getDeltaTime() const
+    {
+        return _delta_time;
+    }
+
+    /**
+     * Sets the value read by the Room's objects with ILoop::getInterpolation() on renderLoop(). Set by the Game before
+     * every rendered frame.
+     */
+    [[maybe_unused]] void setInterpolation(float interpolation)
+    {
+        _interpolation = interpolation;
+    }
+
+    /**
+     * @brief Threads used to run the loop() of the top Elements.
+     *
+     * With more than one thread, the top Elements whose subtrees only hold ANY_THREAD Components are run as jobs on
+     * the JobSystem of the Room, the remaining ones run afterwards on the main thread in their usual order. Every
+     * subtree runs on one thread, so Components must not touch other top Elements. Structural changes must be recorded
+     * on the CommandBuffer, which is applied once every Element is done. Rooms using a TransformStore always run on
+     * the main thread.
+     * @param threads threads to use including the main one, 0 uses one per hardware thread. 1 by default.
+     */
+    [[maybe_unused]] void setLoopThreads(unsigned int threads)
+    {
+        _loop_threads = threads;
+    }
+
+    /**
+     * @return scheduler used by loop(), created on the first call. Components can spawn jobs and use parallelFor() on
+     * it from their loop().
+     */
+    JobSystem &getJobSystem();
+
+    /**
+     * @return commands applied at the end of every loop(), after the loop of every Element.
+     */
+    [[nodiscard]] CommandBuffer &getCommands()
+    {
+        return _commands;
+    }
+
+    /**
+     * @return Game holding the Room, empty if the Room wasn't added to any Game.
+     */
+    [[nodiscard]] std::shared_ptr<Game> getGame() const
+    {
+        return _game.lock();
+    }
+
+    void setGame(std::weak_ptr<Game> game)
+    {
+        _game = std::move(game);
+    }
+
+    /**
+     * Makes the next loop() remove the Elements marked for destruction, called by them when destroyed.
+     */
+    void requestPurge()
+    {
+        _purge_pending = true;
+    }
+
+    /**
+     * @return pools of the Elements and Components under the Room.
+     */
+    [[nodiscard]] const std::shared_ptr<RoomArena> &getArena() const
+    {
+        return _arena;
+    }
+
+    /**
+     * @brief Threads used to propagate the world coordinates of the Room at the start of every loop().
+     *
+     * With more than one thread loop() brings every world coordinate under the Room up to date before the Elements
+     * run, splitting the subtrees of the top Elements across the threads. Rooms smaller than the parallel threshold
+     * still propagate on the main thread. With one thread, the default, world coordinates are only computed when read.
+     * @param worker_threads threads to use including the main one, 0 uses one per hardware thread.
+     */
+    [[maybe_unused]] void setTransformThreads(unsigned int worker_threads)
+    {
+        _transform_threads = worker_threads;
+    }
+
+    /**
+     * @param parallel_threshold minimum amount of objects under the Room, as counted by the last propagation, to split
+     * the propagation across threads.
+     */
+    [[maybe_unused]] void setTransformParallelThreshold(std::size_t parallel_threshold)
+    {
+        _transform_parallel_threshold = parallel_threshold;
+    }
+
+    /**
+     * @return time taken by the last propagateTransforms().
+     */
+    [[nodiscard]] sf::Time getTransformPropagationTime() const
+    {
+        return _transform_propagation_time;
+    }
+
+    /**
+     * Brings the world coordinates of the Room and every object under it up to date, see setTransformThreads().
+     * @return amount of objects updated, including the Room.
+     */
+    std::size_t propagateTransforms();
+
+    /**
+     * @return collision world of the Triggers under this Room, created on the first call.
+     */
+    std::shared_ptr<trigger_world> getTriggerWorld();
+
+    /**
+     * @return Trigger subscribed with handle on this Room, empty if it unsubscribed or no longer exists. O(1).
+     */
+    [[nodiscard]] std::shared_ptr<Trigger> findTrigger(trigger_handle handle) const;
+
+    // Spatial queries
+    // Answered by the same structures used for the superposition checks, with the positions Triggers had when they
+    // were last built (once per frame). Only active Triggers under this Room whose category shares a bit with mask are
+    // reported. Results are written on a vector provided by the caller, cleared first, so reusing it doesn't allocate.
+    // Queries may rebuild those structures, so they are main thread only: they must not be called from ANY_THREAD
+    // Components looping on the JobSystem of the Room.
+
+    /**
+     * @param point world position, Triggers touching it on their border are included.
+     * @param result Triggers containing the point sorted by subscription order.
+     * @return amount of Triggers found.
+     */
+    std::size_t queryPoint(sf::Vector2f point, std::vector<std::shared_ptr<Trigger>> &result,
+                           std::uint32_t mask = 0xFFFFFFFF);
+
+    /**
+     * @param rect world rectangle, superposed the same way two Triggers are.
+     * @param result Triggers superposed with the rectangle sorted by subscription order.
+     * @return amount of Triggers found.
+     */
+    std::size_t queryRect(const sf::FloatRect &rect, std::vector<std::shared_ptr<Trigger>> &result,
+                          std::uint32_t mask = 0xFFFFFFFF);
+
+    /**
+     * @param center world position of the circle's center.
+     * @param result Triggers superposed with the circle sorted by subscription order.
+     * @return amount of Triggers found.
+     */
+    std::size_t queryCircle(sf::Vector2f center, float radius, std::vector<std::shared_ptr<Trigger>> &result,
+                            std::uint32_t mask = 0xFFFFFFFF);
+
+    /**
+     * Finds the closest Trigger hit by a ray, Triggers behind it are skipped without being tested.
+     * @param direction doesn't need to be normalized, a zero direction hits nothing.
+     * @param max_distance length of the ray.
+     * @param hit set to the closest hit, ties are resolved by subscription order.
+     * @return true if a Trigger was hit.
+     */
+    bool raycast(sf::Vector2f origin, sf::Vector2f direction, float max_distance, raycast_hit &hit,
+                 std::uint32_t mask = 0xFFFFFFFF);
+
+    /**
+     * Finds every Trigger hit by a ray.
+     * @param direction doesn't need to be normalized, a zero direction hits nothing.
+     * @param max_distance length of the ray.
+     * @param hits Triggers hit sorted by distance and then by subscription order.
+     * @return amount of Triggers hit.
+     */
+    std::size_t raycastAll(sf::Vector2f origin, sf::Vector2f direction, float max_distance,
+                           std::vector<raycast_hit> &hits, std::uint32_t mask = 0xFFFFFFFF);
+
 #ifdef GDM_TESTING_ENABLED
     template <class T> unsigned long getLoopTypeCount()
     {
@@ -295,7 +1172,8 @@ class Room : public mate::LocalCoords, public ILoop
      * @brief Adds a preexisting Element to the Room.
      *
      * This allows for an Element to move between Rooms. When doing so, the Element position coordinates must be taken
-     * in account, this responsibility lays on the user.
+     * in account, this responsibility lays on the user. Elements that already belong to a Room keep the RoomArena of
+     * that Room.
      * @param element Element to be added
      */
     [[maybe_unused]] void addElement(std::shared_ptr<Element> element);
@@ -310,8 +1188,9 @@ class Room : public mate::LocalCoords, public ILoop
     /**
      * @brief Communicates to all the Element objects within the Room that they should run their main loop functions.
      *
-     * After all the child Element objects have run their main loops, the Element list is purged to effectively
-     * destroy any Element objects that are marked for removal.
+     * After all the child Element objects have run their main loops the CommandBuffer of the Room is applied, then
+     * the Element list is purged to effectively destroy any Element objects that are marked for removal, if any
+     * asked for it.
      */
     void loop() override;
 
@@ -331,12 +1210,12 @@ class Room : public mate::LocalCoords, public ILoop
 };
 
 /**
- * @brief Main game singleton class.
+ * @brief Main game class.
  *
- * Game contains all of the Room objects from the game, runs the loop() method of the active one, tracks the window(s)
- * and keeps the TriggerManager.
+ * Game contains all of the Room objects from the game, runs the loop() method of the active one and tracks the
+ * window(s). getGame() gives the default Game, create() independent ones that can run on their own threads.
  */
-class Game
+class Game : public std::enable_shared_from_this<Game>
 {
   private:
     std::list<std::shared_ptr<Room>> _rooms;
@@ -344,16 +1223,37 @@ class Game
     render_target _main_render_target;
     std::list<render_target> _secondary_targets;
     static std::shared_ptr<Game> _instance;
+    static std::mutex _instance_mutex;
+    const GameMode _mode;
+    u_int _next_target_id = 1;
+
+    sf::Time _fixed_step; ///< Simulated time of every tick, zero for one tick per frame.
+    unsigned int _max_ticks_per_frame = 5;
+    unsigned int _framerate_limit = 60;
+    sf::Clock _frame_clock;
+    sf::Time _accumulator; ///< Real time not simulated yet, always below _fixed_step after a frame.
 
     /**
-     * Private constructor. Generates the window.
+     * Private constructor. Generates the window, or its null stand-in when headless.
      */
-    Game()
+    explicit Game(GameMode mode_ = WINDOWED)
+        : _main_render_target(makeTarget(mode_, 0, sf::View(sf::FloatRect(0, 0, 800, 400)), "Game")), _mode(mode_)
     {
-        _main_render_target.target = std::make_unique<sf::RenderWindow>(sf::VideoMode(800, 400), "Game");
         _active_room = nullptr;
     };
 
+    /**
+     * @return new render_target of 800x400, a window or its null stand-in depending on mode_.
+     */
+    [[nodiscard]] static render_target makeTarget(GameMode mode_, u_int id_, const sf::View &view_,
+                                                  const std::string &title);
+
+    /**
+     * @return render_target with id_, 0 for the main one. nullptr if there is none.
+     */
+    [[nodiscard]] const render_target *findTarget(u_int id_) const;
+    [[nodiscard]] render_target *findTarget(u_int id_);
+
   public:
     Game(Game &other) = delete;
     void operator=(const Game &) = delete;
@@ -365,29 +1265,40 @@ class Game
     /**
      * Sets the main window's view to the default view.
      */
-    void setWindowView() const
-    {
-        _main_render_target.target->setView(_main_render_target.target->getDefaultView());
-    }
+    void setWindowView() const;
 
 #ifdef GDM_TESTING_ENABLED
     [[nodiscard]] sf::View getView(u_int id_) const
     {
-        if (id_ == 0)
-        {
-            return _main_render_target.target->getView();
-        }
-        for (auto &target : _secondary_targets)
+        const render_target *target = findTarget(id_);
+        if (!target)
         {
-            if (target.id == id_)
-            {
-                return target.target->getView();
-            }
+            return {};
         }
-        return {};
+        return target->target ? target->target->getView() : target->headless->view;
     }
 #endif
 
+    [[nodiscard]] GameMode getMode() const
+    {
+        return _mode;
+    }
+
+    [[nodiscard]] bool isHeadless() const
+    {
+        return _mode == HEADLESS;
+    }
+
+    /**
+     * @return sprites drawn on the render target since it was last cleared, on a full frame the ones drawn by that
+     * frame. Counted on every mode.
+     */
+    [[nodiscard]] std::size_t getDrawCalls(u_int id_ = 0) const
+    {
+        const render_target *target = findTarget(id_);
+        return target ? target->draw_calls : 0;
+    }
+
     [[nodiscard]] sf::Vector2i getWindowPosition(uint id_ = 0) const;
     void setWindowPosition(int x, int y, uint id_ = 0) const;
     [[nodiscard]] sf::Vector2u getWindowSize(uint id_ = 0) const;
@@ -410,13 +1321,14 @@ class Game
     // Rooms related stuff
     [[maybe_unused]] void addRoom(std::shared_ptr<Room> room)
     {
+        room->setGame(weak_from_this());
         _rooms.push_back(std::move(room));
     }
 
     [[maybe_unused]] std::shared_ptr<Room> addRoom()
     {
         auto room = std::make_shared<Room>();
-        _rooms.push_back(room);
+        addRoom(room);
         return std::move(room);
     }
 
@@ -425,11 +1337,83 @@ class Game
         return _active_room;
     }
 
+    // Timing
+    /**
+     * @brief Simulates the active Room with a fixed timestep.
+     *
+     * Every frame runs as many ticks of the active Room as fit on the real time elapsed, so the simulation runs at the
+     * same speed on any framerate, and renders between the last two ticks, see ILoop::getInterpolation(). By default
+     * (zero) every frame runs exactly one tick, whose delta time is the real time elapsed since the previous frame.
+     * @param fixed_step simulated time of every tick, zero to go back to one tick per frame.
+     */
+    [[maybe_unused]] void setFixedStep(sf::Time fixed_step)
+    {
+        _fixed_step = std::max(fixed_step, sf::Time::Zero);
+        _accumulator = sf::Time::Zero;
+    }
+
+    [[nodiscard]] sf::Time getFixedStep() const
+    {
+        return _fixed_step;
+    }
+
+    /**
+     * Limits the ticks run by one frame. When ticks take longer than the step itself, catching up would take longer
+     * every frame, instead the simulation slows down and the remaining time is dropped. 5 by default.
+     */
+    [[maybe_unused]] void setMaxTicksPerFrame(unsigned int max_ticks)
+    {
+        _max_ticks_per_frame = std::max(max_ticks, 1u);
+    }
+
+    /**
+     * Limits the frames rendered per second, 60 by default. 0 leaves the limit to the vertical sync instead.
+     */
+    [[maybe_unused]] void setFramerateLimit(unsigned int framerate_limit)
+    {
+        _framerate_limit = framerate_limit;
+        if (_main_render_target.target)
+        {
+            _main_render_target.target->setFramerateLimit(framerate_limit);
+            _main_render_target.target->setVerticalSyncEnabled(framerate_limit == 0);
+        }
+    }
+
+    /**
+     * @return fraction of a step not simulated yet after the last frame, see ILoop::getInterpolation(). 1 without a
+     * fixed step.
+     */
+    [[nodiscard]] float getInterpolation() const
+    {
+        return _fixed_step > sf::Time::Zero ? _accumulator / _fixed_step : 1;
+    }
+
     // Longer methods declarations
 
-    // Singleton getters
+    /**
+     * @brief Generates a new Game independent from every other one, the default Game included.
+     *
+     * Every Game owns its Rooms, with their Elements, Triggers and Component storage, and its render targets, so
+     * different Games can run their frames on different threads at the same time. A Game must only be used from one
+     * thread at a time, and a window must stay on the thread that created it.
+     * @param mode_ HEADLESS for simulations without windows, like servers or benchmarks.
+     * @return Game object with an active empty Room.
+     */
+    [[maybe_unused]] static std::shared_ptr<Game> create(GameMode mode_ = WINDOWED);
+
+    // Default Game getters
 
+    /**
+     * @return default Game, generated the first time. Components outside of any Game's Rooms use it.
+     */
     static std::shared_ptr<Game> getGame();
+    /**
+     * Generates a new Game object on the desired mode only if there isn't an already existing Game, the mode of an
+     * existing Game can't be changed.
+     * @param mode_ HEADLESS for simulations without windows, like servers or benchmarks.
+     * @return Game object.
+     */
+    [[maybe_unused]] static std::shared_ptr<Game> getGame(GameMode mode_);
     /**
      * Generates a new Game object with the desired parameters only if there isn't an already existing Game.
      * @param win_width_ width of the main game window.
@@ -457,17 +1441,31 @@ class Game
 
     // Todo: Switch rooms by using a unique ID given by the room itself.
     /**
-     * Switch the active room
+     * Switch the active room. Every Room keeps its own Triggers, so the Triggers of the other Rooms are not touched
+     * and keep their contacts until their Room is active again.
      * @param position_ of the desired room on the game rooms list
      */
     void switchRoom(int position_);
 
     /**
-     * Main game loop
+     * Main game loop, runs until the main window is closed. A headless Game runs until the program exits.
      */
     [[noreturn]] void gameLoop();
 
+    /**
+     * Handles the window events, simulates the real time elapsed since the last frame and renders the active Room.
+     * A headless Game simulates one step instead, the fixed step or 1/60 of a second, without waiting for it.
+     */
     void runSingleFrame();
+
+    /**
+     * @brief Runs the ticks of the active Room that fit on elapsed plus the time left by the previous frames.
+     *
+     * Without a fixed step runs one tick of elapsed instead, see setFixedStep().
+     * @param elapsed real time to simulate.
+     * @return amount of ticks run, at most the max ticks per frame.
+     */
+    unsigned int simulate(sf::Time elapsed);
 };
 
 using game_instance = std::shared_ptr<Game>;
@@ -35,13 +35,28 @@ class Camera : public Component
     };
 
   private:
+    /**
+     * The handle is checked every frame, the weak_ptr is only kept for the public methods.
+     */
+    struct visible_sprite
+    {
+        std::weak_ptr<const Sprite> sprite;
+        object_handle handle;
+    };
+
     sf::View _view;
-    std::weak_ptr<Game> _game_manager;
-    std::list<std::weak_ptr<const Sprite>> _visible_sprites;
+    std::weak_ptr<Game> _game_manager; ///< Set by findGame().
+    std::list<visible_sprite> _visible_sprites;
 
     float _aspect_ratio;
     ScaleType _scale_type = RESCALE;
 
+    /**
+     * @return Game of the Room holding the Camera, nullptr if the Room isn't on any Game. The default Game is never
+     * created from here, it would open a window behind the back of headless Games.
+     */
+    std::shared_ptr<Game> findGame();
+
   public:
     u_int target_id = 0; ///< id value of the target (window) to print into.
 
@@ -74,13 +89,16 @@ class Camera : public Component
 
     void addSprite(const std::weak_ptr<const Sprite> &sprite)
     {
-        _visible_sprites.push_back(sprite);
+        if (const auto spt_sprite = sprite.lock())
+        {
+            _visible_sprites.push_back({sprite, spt_sprite->getHandle()});
+        }
     }
 
     void removeSprite(const std::shared_ptr<const Sprite> &sprite)
     {
         _visible_sprites.remove_if(
-            [&sprite](const std::weak_ptr<const Sprite> &weak_sprite) { return weak_sprite.lock() == sprite; });
+            [&sprite](const visible_sprite &visible) { return visible.handle == sprite->getHandle(); });
     }
 
     // Other methods declarations
@@ -90,6 +108,7 @@ class Camera : public Component
     [[maybe_unused]] float getRatio();
     /**
      * Generates a new render_target (window by default) to print the view into.
+     * @return id of the new target, target_id unchanged if the Room of the Camera isn't on any Game yet.
      */
     unsigned int useNewTarget(const std::string &title);
     void loop() override{};
@@ -99,12 +118,12 @@ class Camera : public Component
 #ifdef GDM_TESTING_ENABLED
     std::weak_ptr<const Sprite> getTopSprite()
     {
-        return _visible_sprites.front();
+        return _visible_sprites.front().sprite;
     }
 
     std::weak_ptr<const Sprite> getBottomSprite()
     {
-        return _visible_sprites.back();
+        return _visible_sprites.back().sprite;
     }
 
     sf::View getView() const
@@ -0,0 +1,284 @@
+/**
+ * @brief ComponentStorage and ComponentTable classes, IComponentTable interface and loop override concepts
+ * declaration.
+ * @file
+ */
+
+#ifndef GDMATE_COMPONENTSTORAGE_H
+#define GDMATE_COMPONENTSTORAGE_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mate
+{
+class ILoop;
+
+/**
+ * Verifies if T overrides ILoop::renderLoop(), either itself or through one of its bases. Types where the method is
+ * overloaded are assumed to override it.
+ * @tparam T Class that inherits from ILoop.
+ */
+template <class T>
+concept overrides_render_loop = !requires { requires std::is_same_v<decltype(&T::renderLoop), void (ILoop::*)()>; };
+
+/**
+ * Verifies if T overrides ILoop::windowResizeEvent(), see overrides_render_loop.
+ * @tparam T Class that inherits from ILoop.
+ */
+template <class T>
+concept overrides_window_resize_event =
+    !requires { requires std::is_same_v<decltype(&T::windowResizeEvent), void (ILoop::*)()>; };
+
+/**
+ * @return a new id on every call, starting from 0.
+ */
+std::size_t nextComponentTypeId();
+
+/**
+ * @brief Small sequential id of a Component type, assigned the first time it's asked for.
+ * @tparam T Component type.
+ */
+template <class T> std::size_t componentTypeId()
+{
+    static const std::size_t id = nextComponentTypeId();
+    return id;
+}
+
+/**
+ * @brief Interface. The systems of a ComponentTable, run by the Room for every Component of the table.
+ */
+class IComponentTable
+{
+  public:
+    virtual ~IComponentTable() = default;
+    virtual void loop() = 0;
+    virtual void renderLoop() = 0;
+    virtual void windowResizeEvent() = 0;
+    /**
+     * @return true if the Component type overrides ILoop::renderLoop().
+     */
+    [[nodiscard]] virtual bool hasRenderLoop() const = 0;
+    /**
+     * @return true if the Component type overrides ILoop::windowResizeEvent().
+     */
+    [[nodiscard]] virtual bool hasWindowResizeEvent() const = 0;
+    /**
+     * @return amount of Components on the table.
+     */
+    [[nodiscard]] virtual std::size_t size() const = 0;
+};
+
+/**
+ * @brief Contiguous storage for all the Components of one type under a Room.
+ *
+ * Components are built in place on fixed size chunks, so they never move and the shared_ptr given to the Element
+ * stays valid, while the systems walk every chunk in order calling the methods of T directly instead of through the
+ * vtable. Releasing the last shared_ptr destroys the Component and frees its slot for the next one.
+ * @tparam T Component type, stored exactly, derived types get their own table.
+ */
+template <class T> class ComponentTable : public IComponentTable, public std::enable_shared_from_this<ComponentTable<T>>
+{
+  public:
+    static constexpr std::size_t chunk_size = 64;
+
+    ComponentTable() = default;
+    ComponentTable(const ComponentTable &) = delete;
+    ComponentTable &operator=(const ComponentTable &) = delete;
+
+    /**
+     * Builds a Component on a free slot.
+     * @return owner of the Component, it keeps the table alive.
+     */
+    template <class... Args> std::shared_ptr<T> create(Args &&...args)
+    {
+        std::size_t index;
+        if (!_free_slots.empty())
+        {
+            index = _free_slots.back();
+            _free_slots.pop_back();
+        }
+        else
+        {
+            index = _chunks.size() * chunk_size;
+            _chunks.push_back(std::make_unique<chunk>());
+            for (std::size_t free = index + chunk_size - 1; free > index; --free)
+            {
+                _free_slots.push_back(free);
+            }
+        }
+        chunk &current = *_chunks[index / chunk_size];
+        T *component = new (current.slots[index % chunk_size].bytes) T(std::forward<Args>(args)...);
+        current.alive[index % chunk_size] = true;
+        ++_size;
+        return std::shared_ptr<T>(component, [table = this->shared_from_this(), index](T *released) {
+            released->~T();
+            table->release(index);
+        });
+    }
+
+    /**
+     * Calls function with every Component of the table, in slot order.
+     */
+    template <class Function> void forEach(Function &&function)
+    {
+        // Components created by function are placed on free slots and may be visited on the same pass
+        for (std::size_t chunk_index = 0; chunk_index < _chunks.size(); ++chunk_index)
+        {
+            chunk &current = *_chunks[chunk_index];
+            for (std::size_t i = 0; i < chunk_size; ++i)
+            {
+                if (current.alive[i])
+                {
+                    function(*std::launder(reinterpret_cast<T *>(current.slots[i].bytes)));
+                }
+            }
+        }
+    }
+
+    void loop() override
+    {
+        forEach([](T &component) {
+            if (!component.shouldDestroy() && !component.isSleeping())
+            {
+                component.T::loop();
+            }
+        });
+    }
+
+    void renderLoop() override
+    {
+        forEach([](T &component) {
+            if (!component.isSleeping())
+            {
+                component.T::renderLoop();
+            }
+        });
+    }
+
+    void windowResizeEvent() override
+    {
+        forEach([](T &component) {
+            if (!component.isSleeping())
+            {
+                component.T::windowResizeEvent();
+            }
+        });
+    }
+
+    [[nodiscard]] bool hasRenderLoop() const override
+    {
+        return overrides_render_loop<T>;
+    }
+
+    [[nodiscard]] bool hasWindowResizeEvent() const override
+    {
+        return overrides_window_resize_event<T>;
+    }
+
+    [[nodiscard]] std::size_t size() const override
+    {
+        return _size;
+    }
+
+  private:
+    struct slot
+    {
+        alignas(T) std::byte bytes[sizeof(T)];
+    };
+
+    struct chunk
+    {
+        slot slots[chunk_size];
+        bool alive[chunk_size] = {};
+    };
+
+    std::vector<std::unique_ptr<chunk>> _chunks;
+    std::vector<std::size_t> _free_slots; ///< Lowest slots at the back, so the chunks are filled in order.
+    std::size_t _size = 0;
+
+    void release(const std::size_t index)
+    {
+        _chunks[index / chunk_size]->alive[index % chunk_size] = false;
+        _free_slots.push_back(index);
+        --_size;
+    }
+};
+
+/**
+ * @brief Per Room set of ComponentTable, one per stored Component type.
+ *
+ * See Room::useComponentStorage().
+ */
+class ComponentStorage
+{
+  public:
+    /**
+     * @return table of the Components of type T, created on the first call.
+     */
+    template <class T> ComponentTable<T> &getTable()
+    {
+        const std::size_t id = componentTypeId<T>();
+        if (id >= _tables.size())
+        {
+            _tables.resize(id + 1);
+        }
+        if (!_tables[id])
+        {
+            auto table = std::make_shared<ComponentTable<T>>();
+            _tables[id] = table;
+            _systems.push_back(table.get());
+            if (table->hasRenderLoop())
+            {
+                _render_systems.push_back(table.get());
+            }
+            if (table->hasWindowResizeEvent())
+            {
+                _resize_systems.push_back(table.get());
+            }
+        }
+        return static_cast<ComponentTable<T> &>(*_tables[id]);
+    }
+
+    /**
+     * Runs the loop of every table, in the order the tables were created. renderLoop() and windowResizeEvent() only
+     * run the tables whose type overrides them.
+     */
+    void loop()
+    {
+        // Indexes, Components may create new tables
+        for (std::size_t system = 0; system < _systems.size(); ++system)
+        {
+            _systems[system]->loop();
+        }
+    }
+
+    void renderLoop()
+    {
+        for (std::size_t system = 0; system < _render_systems.size(); ++system)
+        {
+            _render_systems[system]->renderLoop();
+        }
+    }
+
+    void windowResizeEvent()
+    {
+        for (std::size_t system = 0; system < _resize_systems.size(); ++system)
+        {
+            _resize_systems[system]->windowResizeEvent();
+        }
+    }
+
+  private:
+    std::vector<std::shared_ptr<IComponentTable>> _tables; ///< Indexed by componentTypeId().
+    std::vector<IComponentTable *> _systems;               ///< Tables in creation order.
+    std::vector<IComponentTable *> _render_systems;        ///< Tables whose type overrides renderLoop().
+    std::vector<IComponentTable *> _resize_systems;        ///< Tables whose type overrides windowResizeEvent().
+};
+} // namespace mate
+
+#endif // GDMATE_COMPONENTSTORAGE_H
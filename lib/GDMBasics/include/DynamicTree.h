@@ -0,0 +1,255 @@
+/**
+ * @brief DynamicTree class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_DYNAMICTREE_H
+#define GDMATE_DYNAMICTREE_H
+
+#include "NarrowPhase.h"
+#include <SFML/Graphics.hpp>
+#include <utility>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Dynamic bounding volume hierarchy broad-phase.
+ *
+ * DynamicTree keeps a balanced binary tree of axis aligned bounding boxes. Every entry (proxy) is a leaf that stores
+ * its box enlarged by a margin (fat bounds), so small movements inside the fat bounds don't change the tree at all and
+ * only the proxies that leave it are reinserted. Insertion picks the sibling that grows the tree perimeter the least
+ * and AVL like rotations keep the height logarithmic, so creating, destroying and moving a proxy is O(log n).
+ *
+ * Proxies are identified by the node index returned by createProxy(), which stays valid until destroyProxy() and may
+ * be reused afterwards. Bounds are treated as closed intervals, boxes touching on an edge overlap.
+ */
+class DynamicTree
+{
+  public:
+    static constexpr int null_node = -1;
+
+    explicit DynamicTree(float margin = 4.0f);
+
+    /**
+     * @param margin distance added on every side of the proxies bounds. Only affects proxies inserted afterwards.
+     */
+    void setMargin(float margin)
+    {
+        _margin = margin > 0 ? margin : 0;
+    }
+
+    [[nodiscard]] float getMargin() const
+    {
+        return _margin;
+    }
+
+    /**
+     * Inserts a new leaf on the tree.
+     * @param bounds tight bounds of the proxy, width and height are expected to be non negative.
+     * @return proxy id.
+     */
+    int createProxy(const sf::FloatRect &bounds);
+
+    /**
+     * Removes a leaf from the tree, proxy is no longer valid after this.
+     */
+    void destroyProxy(int proxy);
+
+    /**
+     * Reinserts the proxy only if bounds is not contained by its fat bounds.
+     * @param bounds new tight bounds of the proxy.
+     * @return true if the proxy was reinserted.
+     */
+    bool moveProxy(int proxy, const sf::FloatRect &bounds);
+
+    [[nodiscard]] const sf::FloatRect &getFatBounds(int proxy) const
+    {
+        return _nodes[proxy].bounds;
+    }
+
+    /**
+     * @return height of the tree, 0 if there is only one proxy and -1 if there are none.
+     */
+    [[nodiscard]] int getHeight() const
+    {
+        return _root == null_node ? -1 : _nodes[_root].height;
+    }
+
+    [[nodiscard]] int getProxyCount() const
+    {
+        return _proxy_count;
+    }
+
+    /**
+     * Calls callback(proxy) for every proxy whose fat bounds overlap bounds.
+     */
+    template <typename Callback> void query(const sf::FloatRect &bounds, Callback &&callback) const
+    {
+        if (_root == null_node)
+        {
+            return;
+        }
+        _stack.clear();
+        _stack.emplace_back(_root, _root);
+        while (!_stack.empty())
+        {
+            const int index = _stack.back().first;
+            _stack.pop_back();
+
+            const node &current = _nodes[index];
+            if (!overlaps(current.bounds, bounds))
+            {
+                continue;
+            }
+            if (current.isLeaf())
+            {
+                callback(index);
+            }
+            else
+            {
+                _stack.emplace_back(current.child_a, current.child_a);
+                _stack.emplace_back(current.child_b, current.child_b);
+            }
+        }
+    }
+
+    /**
+     * Calls callback(proxy) for every proxy whose fat bounds are hit by a ray. The callback returns the new length of
+     * the ray, returning a shorter one skips the proxies that are farther away.
+     * @param direction normalized direction of the ray.
+     */
+    template <typename Callback>
+    void raycast(const sf::Vector2f origin, const sf::Vector2f direction, float max_distance,
+                 Callback &&callback) const
+    {
+        if (_root == null_node)
+        {
+            return;
+        }
+        _stack.clear();
+        _stack.emplace_back(_root, _root);
+        while (!_stack.empty())
+        {
+            const int index = _stack.back().first;
+            _stack.pop_back();
+
+            const node &current = _nodes[index];
+            float distance;
+            if (!rayToBoxCheck(origin, direction, max_distance, current.bounds.left, current.bounds.top,
+                               current.bounds.left + current.bounds.width, current.bounds.top + current.bounds.height,
+                               distance))
+            {
+                continue;
+            }
+            if (current.isLeaf())
+            {
+                max_distance = callback(index);
+            }
+            else
+            {
+                _stack.emplace_back(current.child_a, current.child_a);
+                _stack.emplace_back(current.child_b, current.child_b);
+            }
+        }
+    }
+
+    /**
+     * Traverses the tree against itself and calls callback(proxy_a, proxy_b) once for every pair of different proxies
+     * with overlapping fat bounds. Subtrees are only descended when their bounds overlap, so the cost depends on the
+     * amount of overlapping pairs instead of the square of the proxy count.
+     */
+    template <typename Callback> void queryPairs(Callback &&callback) const
+    {
+        if (_root == null_node)
+        {
+            return;
+        }
+        _stack.clear();
+        _stack.emplace_back(_root, _root);
+        while (!_stack.empty())
+        {
+            const auto [index_a, index_b] = _stack.back();
+            _stack.pop_back();
+
+            const node &a = _nodes[index_a];
+            if (index_a == index_b)
+            {
+                // Pairs within the same subtree
+                if (!a.isLeaf())
+                {
+                    _stack.emplace_back(a.child_a, a.child_a);
+                    _stack.emplace_back(a.child_b, a.child_b);
+                    _stack.emplace_back(a.child_a, a.child_b);
+                }
+                continue;
+            }
+
+            const node &b = _nodes[index_b];
+            if (!overlaps(a.bounds, b.bounds))
+            {
+                continue;
+            }
+            if (a.isLeaf() && b.isLeaf())
+            {
+                callback(index_a, index_b);
+            }
+            else if (b.isLeaf() || (!a.isLeaf() && a.height >= b.height))
+            {
+                _stack.emplace_back(a.child_a, index_b);
+                _stack.emplace_back(a.child_b, index_b);
+            }
+            else
+            {
+                _stack.emplace_back(index_a, b.child_a);
+                _stack.emplace_back(index_a, b.child_b);
+            }
+        }
+    }
+
+    static bool overlaps(const sf::FloatRect &a, const sf::FloatRect &b)
+    {
+        return a.left <= b.left + b.width && b.left <= a.left + a.width && a.top <= b.top + b.height &&
+               b.top <= a.top + a.height;
+    }
+
+  private:
+    struct node
+    {
+        sf::FloatRect bounds;
+        int parent = null_node; ///< Next free node when the node is on the free list.
+        int child_a = null_node;
+        int child_b = null_node;
+        int height = -1; ///< 0 for leaves, -1 for free nodes.
+
+        [[nodiscard]] bool isLeaf() const
+        {
+            return child_a == null_node;
+        }
+    };
+
+    std::vector<node> _nodes;
+    int _root = null_node;
+    int _free_list = null_node;
+    int _proxy_count = 0;
+    float _margin;
+    /// Traversal stack, kept to avoid allocations on every query.
+    mutable std::vector<std::pair<int, int>> _stack;
+
+    int allocateNode();
+    void freeNode(int index);
+    void insertLeaf(int leaf);
+    void removeLeaf(int leaf);
+    /**
+     * Refits bounds and heights from index up to the root, rotating unbalanced nodes on the way.
+     */
+    void fixUpwards(int index);
+    /**
+     * Rotates the subtree at index if its children heights differ by more than one.
+     * @return index of the node that takes the place of index.
+     */
+    int balance(int index);
+};
+} // namespace mate
+
+#endif // GDMATE_DYNAMICTREE_H
@@ -0,0 +1,86 @@
+/**
+ * @brief ElementPool class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_ELEMENTPOOL_H
+#define GDMATE_ELEMENTPOOL_H
+
+#include "Basics.h"
+#include <functional>
+
+namespace mate
+{
+/**
+ * @brief Reusable top Elements of a Room built from a prefab.
+ *
+ * Meant for Elements that are spawned and destroyed many times per second with the same shape, like bullets. The
+ * prefab adds the Components and children once, when the pool builds a new Element. Destroying a pooled Element only
+ * marks it: once the Room purges it, it leaves the Room with its Components intact, they are put to sleep (Triggers
+ * unsubscribe, Sprites stop being drawn) and the Element waits on the pool. spawn() gives it back to the Room, wakes
+ * it and runs the reset hook, so nothing is constructed or allocated again.
+ *
+ * The pool only holds the Elements waiting on it, the active ones belong to the Room. If the pool is destroyed its
+ * active Elements are destroyed as regular Elements.
+ */
+class ElementPool : public std::enable_shared_from_this<ElementPool>
+{
+  public:
+    /// Called with the Element being built or spawned again.
+    using element_hook = std::function<void(const std::shared_ptr<Element> &)>;
+
+    /**
+     * @param room Room the Elements are spawned into.
+     * @param prefab adds the Components and children of every new Element.
+     * @param reset restores the state of the Elements spawned again, optional.
+     */
+    ElementPool(const std::shared_ptr<Room> &room, element_hook prefab, element_hook reset = {});
+
+    /**
+     * @return an Element waiting on the pool, or a new one if there is none, added to the Room. Empty if the Room no
+     * longer exists.
+     */
+    std::shared_ptr<Element> spawn();
+
+    /**
+     * Builds Elements until count of them wait on the pool.
+     */
+    void reserve(std::size_t count);
+
+    /**
+     * Puts element to sleep and keeps it until the next spawn(). Called by the Room when it purges a destroyed pooled
+     * Element.
+     */
+    void release(const std::shared_ptr<Element> &element);
+
+    /**
+     * @return amount of Elements waiting on the pool.
+     */
+    [[nodiscard]] std::size_t getFreeCount() const
+    {
+        return _free_elements.size();
+    }
+
+    /**
+     * @return amount of Elements built by the pool, active or waiting.
+     */
+    [[nodiscard]] std::size_t getBuiltCount() const
+    {
+        return _built_count;
+    }
+
+  private:
+    std::weak_ptr<Room> _room;
+    element_hook _prefab;
+    element_hook _reset;
+    std::vector<std::shared_ptr<Element>> _free_elements;
+    std::size_t _built_count = 0;
+
+    /**
+     * @return a new Element of the Room built with the prefab, not added to the Room's loops.
+     */
+    std::shared_ptr<Element> build(const std::shared_ptr<Room> &room);
+};
+} // namespace mate
+
+#endif // GDMATE_ELEMENTPOOL_H
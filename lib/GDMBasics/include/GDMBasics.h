@@ -7,10 +7,13 @@
 #define GDMATE_GDMBASICS_H
 
 #include "LocalCoords.h"
+#include "TransformStore.h"
 
 #include "Basics.h"
 
 #include "Camera.h"
+#include "ElementPool.h"
+#include "JobSystem.h"
 #include "InputActions.h"
 #include "Sprite.h"
 #include "Trigger.h"
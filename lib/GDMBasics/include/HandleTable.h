@@ -0,0 +1,143 @@
+/**
+ * @brief HandleTable class and object_handle structure declaration.
+ * @file
+ */
+
+#ifndef GDMATE_HANDLETABLE_H
+#define GDMATE_HANDLETABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Generational reference to an object registered on a HandleTable.
+ *
+ * The generation makes old handles fail even if their slot was given to another object.
+ */
+struct object_handle
+{
+    int index = -1;
+    std::uint32_t generation = 0;
+
+    bool operator==(const object_handle &) const = default;
+};
+
+/**
+ * @brief Slots with the address of live objects, addressed by object_handle.
+ *
+ * Checking a handle is an array access and a comparison, unlike locking a std::weak_ptr it doesn't touch any reference
+ * count. Objects register themselves on construction and remove themselves on destruction, which makes every handle
+ * to them fail.
+ *
+ * Slots live on chunks that never move, so get() takes no lock while add() and remove() take one. Objects of
+ * different Games can be created and destroyed on different threads at the same time, handles of one object must
+ * only be checked while nothing destroys that object.
+ */
+template <class T> class HandleTable
+{
+  public:
+    static constexpr int chunk_slots = 4096;
+    static constexpr int max_chunks = 1 << 14;
+
+    HandleTable() : _chunks(std::make_unique<std::atomic<slot *>[]>(max_chunks))
+    {
+    }
+
+    HandleTable(const HandleTable &) = delete;
+    HandleTable &operator=(const HandleTable &) = delete;
+
+    ~HandleTable()
+    {
+        for (int chunk = 0; chunk < max_chunks; ++chunk)
+        {
+            delete[] _chunks[chunk].load(std::memory_order_relaxed);
+        }
+    }
+
+    object_handle add(T *object)
+    {
+        std::lock_guard lock(_mutex);
+        int index;
+        if (!_free_slots.empty())
+        {
+            index = _free_slots.back();
+            _free_slots.pop_back();
+        }
+        else
+        {
+            index = _slots_count++;
+            if (index % chunk_slots == 0)
+            {
+                _chunks[index / chunk_slots].store(new slot[chunk_slots], std::memory_order_release);
+            }
+        }
+        slot &current = at(index);
+        current.object.store(object, std::memory_order_relaxed);
+        return {index, current.generation.load(std::memory_order_relaxed)};
+    }
+
+    void remove(const object_handle handle)
+    {
+        std::lock_guard lock(_mutex);
+        if (get(handle))
+        {
+            slot &current = at(handle.index);
+            current.object.store(nullptr, std::memory_order_relaxed);
+            current.generation.fetch_add(1, std::memory_order_relaxed);
+            _free_slots.push_back(handle.index);
+        }
+    }
+
+    /**
+     * @return registered object, nullptr if it was destroyed or the handle is empty. O(1).
+     */
+    [[nodiscard]] T *get(const object_handle handle) const
+    {
+        if (handle.index < 0 || handle.index >= chunk_slots * max_chunks)
+        {
+            return nullptr;
+        }
+        const slot *chunk = _chunks[handle.index / chunk_slots].load(std::memory_order_acquire);
+        if (!chunk)
+        {
+            return nullptr;
+        }
+        const slot &current = chunk[handle.index % chunk_slots];
+        T *object = current.object.load(std::memory_order_relaxed);
+        return current.generation.load(std::memory_order_relaxed) == handle.generation ? object : nullptr;
+    }
+
+    /**
+     * @return amount of registered objects.
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        std::lock_guard lock(_mutex);
+        return _slots_count - _free_slots.size();
+    }
+
+  private:
+    struct slot
+    {
+        std::atomic<T *> object = nullptr;
+        std::atomic<std::uint32_t> generation = 0;
+    };
+
+    std::unique_ptr<std::atomic<slot *>[]> _chunks; ///< Fixed directory, chunks are only added.
+    int _slots_count = 0;
+    std::vector<int> _free_slots;
+    mutable std::mutex _mutex;
+
+    slot &at(const int index)
+    {
+        return _chunks[index / chunk_slots].load(std::memory_order_relaxed)[index % chunk_slots];
+    }
+};
+} // namespace mate
+
+#endif // GDMATE_HANDLETABLE_H
@@ -38,6 +38,9 @@ class InputActions : public Component
     std::list<action_entry> _actions;
 
   public:
+    /// Kept on the Room's ComponentTable when the Room uses a ComponentStorage.
+    static constexpr bool component_system = true;
+
     // Constructors
     explicit InputActions(const std::weak_ptr<Element> &parent) : Component(parent){};
 
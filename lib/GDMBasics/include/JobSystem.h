@@ -0,0 +1,116 @@
+/**
+ * @brief JobSystem class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_JOBSYSTEM_H
+#define GDMATE_JOBSYSTEM_H
+
+#include "WorkerPool.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+
+namespace mate
+{
+/**
+ * @brief Work stealing scheduler over a WorkerPool.
+ *
+ * Every thread has its own queue of jobs. It takes the newest job of its queue, and once the queue is empty it
+ * steals the oldest job of another thread's queue, so the jobs spawned by a long job end up spread across the
+ * threads. Jobs must not throw.
+ *
+ * Jobs can spawn more jobs and use parallelFor() themselves. A thread waiting for its jobs runs other jobs meanwhile,
+ * so nested waits never block the pool. Releasing objects from a job can be deferred to the end of the batch with
+ * deferRelease(), for objects whose destruction isn't thread safe.
+ */
+class JobSystem
+{
+  public:
+    using job = std::function<void()>;
+
+    /**
+     * @param threads threads running the jobs, including the calling one. 0 uses one per hardware thread.
+     */
+    explicit JobSystem(unsigned int threads = 1);
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    /**
+     * Changes the amount of threads, must not be called from a job.
+     * @param threads threads running the jobs, including the calling one. 0 uses one per hardware thread.
+     */
+    void resize(unsigned int threads);
+
+    /**
+     * @return threads running the jobs, including the calling one.
+     */
+    [[nodiscard]] unsigned int size() const
+    {
+        return _pool.size();
+    }
+
+    /**
+     * Runs jobs and every job they spawn, returns once all of them are done. Must not be called from a job, use
+     * spawn() or parallelFor() there.
+     */
+    void run(std::vector<job> jobs);
+
+    /**
+     * Queues a job on the current batch from a job of this JobSystem, it runs before run() returns. Outside a batch
+     * the job runs right away.
+     */
+    void spawn(job new_job);
+
+    /**
+     * Calls function(i) for every i in [0, count), split in chunks across the threads, and waits for all of them.
+     * Works from a job too, the waiting thread runs jobs meanwhile.
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &function);
+
+    /**
+     * @return true if the calling thread is running a job of any JobSystem.
+     */
+    [[nodiscard]] static bool insideJob()
+    {
+        return current_system != nullptr;
+    }
+
+    /**
+     * Keeps object alive until the batch of the current job ends, it's then released by the thread that called
+     * run(). Outside a batch object is released right away.
+     */
+    static void deferRelease(std::shared_ptr<void> object);
+
+  private:
+    struct job_queue
+    {
+        std::mutex mutex;
+        std::deque<job> jobs;
+        std::vector<std::shared_ptr<void>> released; ///< Objects given to deferRelease() by the queue's thread.
+    };
+
+    WorkerPool _pool;
+    std::vector<std::unique_ptr<job_queue>> _queues; ///< One per thread, indexed by participant.
+    std::atomic<std::size_t> _pending{0};            ///< Jobs queued or running on the current batch.
+
+    static thread_local JobSystem *current_system;
+    static thread_local unsigned int current_participant;
+
+    void push(unsigned int participant, job new_job);
+
+    /**
+     * Runs the newest job of participant's queue, or the oldest one of another queue.
+     * @return false if every queue was empty.
+     */
+    bool runOne(unsigned int participant);
+
+    /**
+     * Runs jobs until done is true.
+     */
+    void helpUntil(unsigned int participant, const std::function<bool()> &done);
+};
+} // namespace mate
+
+#endif // GDMATE_JOBSYSTEM_H
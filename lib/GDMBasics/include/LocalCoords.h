@@ -6,11 +6,16 @@
 #ifndef GDMATE_LOCALCOORDS_H
 #define GDMATE_LOCALCOORDS_H
 
+#include "HandleTable.h"
 #include <SFML/Graphics.hpp>
 #include <memory>
+#include <vector>
 
 namespace mate
 {
+class TransformStore;
+class WorkerPool;
+
 /**
  * @brief Simple template function for the verification of weak_ptr initialization.
  * @param weak weak_ptr to verify.
@@ -74,12 +79,96 @@ class Bounds
  * @brief Local and global coordinates tracking.
  *
  * LocalCoords keeps the current local position, rotation and scale values for an object within the game, and holds a
- * reference to the "parent" object's coordinates to calculate global coordinates.
+ * reference to the "parent" object's coordinates to calculate global coordinates. The world transform is the parent's
+ * world transform combined with the local one, so the local position is moved, rotated and scaled by every ancestor.
+ *
+ * World coordinates are cached. The position, rotation and scale setters mark the object and all its descendants as
+ * dirty, and the world getters only walk up the hierarchy when the cached values are dirty, so every object is
+ * recomputed at most once after its coordinates or the ones of its ancestors change. Changes made through an
+ * sf::Transformable reference bypass this and are not noticed.
+ *
+ * Alternatively a whole hierarchy can keep its world coordinates on a TransformStore, see useTransformStore().
+ *
+ * Either way onWorldInvalidated() is executed when the world coordinates of an object change, once until they are
+ * read again.
+ *
+ * The parent is kept as a std::weak_ptr for the public API, while the hierarchy is walked through object_handle, so
+ * following a parent doesn't touch its reference count.
  */
 class LocalCoords : public sf::Transformable, public std::enable_shared_from_this<LocalCoords>
 {
   private:
     std::weak_ptr<LocalCoords> _parent; ///< Parent's object coordinates reference.
+    object_handle _handle = handles().add(this);
+    /// Parent holding this object on its _children_coords. Unlike _parent it still works while the parent destroys
+    /// its children.
+    object_handle _parent_handle;
+    /// LocalCoords whose parent is this one. They remove themselves on destruction or when changing parent.
+    std::vector<LocalCoords *> _children_coords;
+    std::size_t _child_index = 0; ///< Position on the parent's _children_coords.
+
+    mutable sf::Transform _world_transform;
+    mutable sf::Vector2f _world_scale;
+    mutable float _world_rotation = 0;
+    mutable bool _world_dirty = true; ///< If false the parent's world coordinates are not dirty either.
+
+    std::shared_ptr<TransformStore> _transform_store; ///< If set the world coordinates come from it.
+    int _transform_node = -1;                         ///< Node of this object on _transform_store.
+
+    /**
+     * @return table of every existing LocalCoords.
+     */
+    static HandleTable<LocalCoords> &handles();
+    /**
+     * Recomputes the cached world coordinates if dirty, starting from the parent's.
+     */
+    void updateWorld() const;
+    /**
+     * Marks the world coordinates of this object and its descendants as dirty. Descendants already dirty are skipped,
+     * their own descendants are dirty too.
+     */
+    void invalidateWorld();
+    /**
+     * Called by the setters, marks the cached world coordinates as dirty or updates the store.
+     */
+    void localChanged();
+    /**
+     * Adds the object and its descendants to a store.
+     * @param parent_node node of the parent on the store, -1 if it isn't on it.
+     */
+    void bindStore(const std::shared_ptr<TransformStore> &store, int parent_node);
+    /**
+     * Removes the object and its descendants from their store, going back to the cached world coordinates.
+     */
+    void unbindStore();
+    /**
+     * Brings the world coordinates of the object's descendants up to date, depth first.
+     * @return amount of descendants.
+     */
+    std::size_t updateDescendantsWorld() const;
+    /**
+     * Registers the object on its parent's _children_coords, and on its parent's store if it has one.
+     */
+    void attachToParent();
+    /**
+     * Removes the object from its parent's _children_coords.
+     */
+    void detachFromParent();
+    /**
+     * Clears the dirty flags of an object on a TransformStore and of its ancestors, its world coordinates were just
+     * read from the store.
+     */
+    void markStoreRead() const;
+
+  protected:
+    /**
+     * Executed when the world coordinates of the object change, because it or one of its ancestors changed. Runs
+     * inside the setter that caused it, once until the world coordinates of the object are read again.
+     */
+    virtual void onWorldInvalidated()
+    {
+    }
+
   public:
     /**
      * @brief Pseudo third dimension.
@@ -102,32 +191,67 @@ class LocalCoords : public sf::Transformable, public std::enable_shared_from_thi
     [[maybe_unused]] explicit LocalCoords(sf::Vector2f, sf::Vector2f, const std::shared_ptr<LocalCoords> &parent);
     [[maybe_unused]] explicit LocalCoords(sf::Vector2f, sf::Vector2f, float,
                                           const std::shared_ptr<LocalCoords> &parent);
+    /// The children registry is tied to the object's address.
+    LocalCoords(const LocalCoords &) = delete;
+    LocalCoords &operator=(const LocalCoords &) = delete;
+    ~LocalCoords() override;
 
     // Getters
 
     /**
-     * Recursively calculates object's world position relative to it's parent's world position.
-     * @return local position + parent's world position.
+     * Object's world position relative to it's parent's world transform, O(1) unless it changed.
+     * @return local position transformed by the parent's world transform.
      */
     sf::Vector2f getWorldPosition();
 
     /**
-     * Recursively calculates object's world scale relative to it's parent's world scale.
+     * Object's world scale relative to it's parent's world scale, O(1) unless it changed.
      * @return local scale * parent's world scale.
      */
     sf::Vector2f getWorldScale();
 
     /**
-     * Recursively calculates object's world rotation relative to it's parent's worlds rotation.
+     * Object's world rotation relative to it's parent's worlds rotation, O(1) unless it changed.
      * @return local rotation + parent's world rotation.
      */
     float getWorldRotation() const;
 
+    /**
+     * Affine transform from the object's local space to world space, O(1) unless it changed. Unlike the world scale and
+     * rotation getters it also keeps the shear caused by rotating a non uniformly scaled parent.
+     * @return parent's world transform * local transform.
+     */
+    const sf::Transform &getWorldTransform() const;
+
     std::weak_ptr<LocalCoords> getParent() const
     {
         return _parent;
     }
 
+    /**
+     * @return parent registered through getHandle(), nullptr if it doesn't exist. Doesn't touch reference counts.
+     */
+    [[nodiscard]] LocalCoords *getParentCoords() const
+    {
+        return handles().get(_parent_handle);
+    }
+
+    /**
+     * @return handle of the object, fails once the object is destroyed.
+     */
+    [[nodiscard]] object_handle getHandle() const
+    {
+        return _handle;
+    }
+
+    /**
+     * @return object referenced by handle, nullptr if it was destroyed. O(1) and without reference counts.
+     */
+    static LocalCoords *fromHandle(object_handle handle)
+    {
+        return handles().get(handle);
+    }
+
     /**
      * @deprecated depth is now a public variable.
      */
@@ -146,10 +270,51 @@ class LocalCoords : public sf::Transformable, public std::enable_shared_from_thi
         depth = depth_;
     }
 
-    void setParent(const std::weak_ptr<LocalCoords> &parent)
+    /**
+     * Objects that change to a parent on a different store leave theirs, and join the new parent's store.
+     */
+    void setParent(const std::weak_ptr<LocalCoords> &parent);
+
+    /**
+     * @brief Moves the whole hierarchy of the object, from its root, to a TransformStore.
+     *
+     * The world getters then read the store, which recomputes the world transforms of the hierarchy in one linear
+     * pass from the first one that changed, instead of walking up the parents of every object. Objects added to the
+     * hierarchy later join the store too. Worth it when most of a big hierarchy moves every frame.
+     * @param store store for the hierarchy, nullptr to go back to the per object cached world coordinates.
+     */
+    void useTransformStore(const std::shared_ptr<TransformStore> &store);
+
+    /**
+     * @brief Brings the world coordinates of the object and all its descendants up to date.
+     *
+     * The world getters compute the coordinates on demand, this computes them all at once, so later reads are O(1).
+     * With a pool the subtrees of the object's children, which don't depend on each other, are split across its
+     * threads. Objects on a TransformStore update the whole store instead, on the calling thread.
+     * @param pool threads to use, nullptr to run on the calling thread only.
+     * @return amount of objects updated, including this one.
+     */
+    std::size_t updateWorldTree(WorkerPool *pool = nullptr);
+
+    [[nodiscard]] std::shared_ptr<TransformStore> getTransformStore() const
     {
-        _parent = parent;
+        return _transform_store;
     }
+
+    // sf::Transformable setters, they also invalidate the cached world coordinates
+
+    void setPosition(float x, float y);
+    void setPosition(const sf::Vector2f &position);
+    void setRotation(float angle);
+    void setScale(float factor_x, float factor_y);
+    void setScale(const sf::Vector2f &factors);
+    void setOrigin(float x, float y);
+    void setOrigin(const sf::Vector2f &origin);
+    void move(float offset_x, float offset_y);
+    void move(const sf::Vector2f &offset);
+    void rotate(float angle);
+    void scale(float factor_x, float factor_y);
+    void scale(const sf::Vector2f &factor);
 };
 } // namespace mate
 
@@ -0,0 +1,141 @@
+/**
+ * @brief Trigger shapes superposition tests, scalar and batched.
+ * @file
+ */
+
+#ifndef GDMATE_NARROWPHASE_H
+#define GDMATE_NARROWPHASE_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace mate
+{
+/// Shapes supported for trigger detection
+enum ShapeType
+{
+    RECTANGLE, ///< Calculated from the top left corner + height/width
+    CIRCLE     ///< Calculated from center + radius [max dimension]
+};
+
+/**
+ * @brief Structure of arrays with the world position, dimensions and shape of a set of Triggers.
+ *
+ * Keeping every value on its own contiguous array allows the batched checks to load the data of several Triggers at
+ * once instead of following pointers to every Trigger and its parents.
+ */
+struct shape_buffer
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<std::int32_t> shape;
+
+    void resize(std::size_t size)
+    {
+        x.resize(size);
+        y.resize(size);
+        width.resize(size);
+        height.resize(size);
+        shape.resize(size);
+    }
+
+    void set(std::size_t index, sf::Vector2f position, sf::Vector2f dimensions, ShapeType shape_type)
+    {
+        x[index] = position.x;
+        y[index] = position.y;
+        width[index] = dimensions.x;
+        height[index] = dimensions.y;
+        shape[index] = shape_type;
+    }
+};
+
+/**
+ * Checks superposition between two rectangle shapes
+ * @param rect1_pos position of the first rectangle's left top corner
+ * @param rect1_dim scale of the first rectangle
+ * @param rect2_pos position of the second rectangle's left top corner
+ * @param rect2_dim scale of the second rectangle
+ * @return true if superposed, false otherwise
+ */
+bool rectangleToRectangleCheck(sf::Vector2f rect1_pos, sf::Vector2f rect1_dim, sf::Vector2f rect2_pos,
+                               sf::Vector2f rect2_dim);
+
+/**
+ * Checks superposition between a rectangle shape and a circle shape
+ * @param circ_pos center of the circle
+ * @param circ_dim scale of the circle (only the biggest of it's two dimensions will be used)
+ * @param rect_pos position of the rectangle's left top corner
+ * @param rect_dim scale of the rectangle
+ * @return true if superposed, false otherwise
+ */
+bool circleToRectangleCheck(sf::Vector2f circ_pos, sf::Vector2f circ_dim, sf::Vector2f rect_pos,
+                            sf::Vector2f rect_dim);
+
+/**
+ * Checks superposition between two circle shapes
+ * @param circ1_pos center of the first circle
+ * @param circ1_dim scale of the first circle (only the biggest dimension will be used)
+ * @param circ2_pos center of the second circle
+ * @param circ2_dim scale of the second circle (only the biggest dimension will be used)
+ * @return true if superposed, false otherwise
+ */
+bool circleToCircleCheck(sf::Vector2f circ1_pos, sf::Vector2f circ1_dim, sf::Vector2f circ2_pos,
+                         sf::Vector2f circ2_dim);
+
+/**
+ * Selects the superposition check that corresponds to the shapes of a and b.
+ * @return true if superposed, false otherwise
+ */
+bool shapesCheck(ShapeType shape_a, sf::Vector2f pos_a, sf::Vector2f dim_a, ShapeType shape_b, sf::Vector2f pos_b,
+                 sf::Vector2f dim_b);
+
+/**
+ * Checks if a point is inside a shape, edges included.
+ * @param shape_pos position of the shape's left top corner.
+ * @param shape_dim scale of the shape.
+ * @return true if inside, false otherwise.
+ */
+bool pointToShapeCheck(sf::Vector2f point, ShapeType shape, sf::Vector2f shape_pos, sf::Vector2f shape_dim);
+
+/**
+ * Checks if a ray hits an axis aligned box, edges included.
+ * @param direction normalized direction of the ray.
+ * @param max_distance length of the ray.
+ * @param distance output, distance from the origin to the hit, 0 if the origin is inside the box.
+ * @return true if hit, false otherwise.
+ */
+bool rayToBoxCheck(sf::Vector2f origin, sf::Vector2f direction, float max_distance, float min_x, float min_y,
+                   float max_x, float max_y, float &distance);
+
+/**
+ * Checks if a ray hits a shape, edges included.
+ * @param direction normalized direction of the ray.
+ * @param max_distance length of the ray.
+ * @param shape_pos position of the shape's left top corner.
+ * @param shape_dim scale of the shape.
+ * @param distance output, distance from the origin to the hit, 0 if the origin is inside the shape.
+ * @return true if hit, false otherwise.
+ */
+bool rayToShapeCheck(sf::Vector2f origin, sf::Vector2f direction, float max_distance, ShapeType shape,
+                     sf::Vector2f shape_pos, sf::Vector2f shape_dim, float &distance);
+
+/**
+ * @brief Batched superposition checks of one shape against a list of candidates.
+ *
+ * Runs on 8 candidates at a time when the library is built with AVX2, 4 at a time with SSE2 and one at a time
+ * otherwise. All versions perform the same floating point operations as shapesCheck(), so the results are identical.
+ * @param shapes data of all the shapes.
+ * @param index position on shapes of the shape to check.
+ * @param candidates positions on shapes of the shapes to check against.
+ * @param count amount of candidates.
+ * @param hits output, the superposed candidates are written here keeping their order. Must fit count values.
+ * @return amount of superposed candidates.
+ */
+std::size_t shapesBatchCheck(const shape_buffer &shapes, int index, const int *candidates, std::size_t count,
+                             int *hits);
+} // namespace mate
+
+#endif // GDMATE_NARROWPHASE_H
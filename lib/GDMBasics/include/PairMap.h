@@ -0,0 +1,192 @@
+/**
+ * @brief PairMap class declaration and definition.
+ * @file
+ */
+
+#ifndef GDMATE_PAIRMAP_H
+#define GDMATE_PAIRMAP_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Flat hash map keyed by unordered pairs of ids.
+ *
+ * All the entries live on a single array with open addressing and linear probing, removals shift the following
+ * entries back instead of leaving tombstones. Memory is only allocated when the map grows past half of its capacity,
+ * so once a set of pairs has been seen, inserting and removing a similar amount of pairs doesn't allocate.
+ *
+ * The pair (a, b) is the same key as (b, a).
+ */
+template <typename Value> class PairMap
+{
+  public:
+    struct entry
+    {
+        std::uint64_t first = 0; ///< Lowest id of the pair.
+        std::uint64_t second = 0;
+        Value value{};
+        bool used = false;
+    };
+
+    /**
+     * @return the value of the pair, nullptr if not present.
+     */
+    Value *find(std::uint64_t a, std::uint64_t b)
+    {
+        if (_size == 0)
+        {
+            return nullptr;
+        }
+        normalize(a, b);
+        const std::size_t index = lookup(a, b);
+        return _entries[index].used ? &_entries[index].value : nullptr;
+    }
+
+    /**
+     * Inserts a default constructed value for the pair if not present.
+     * @return value of the pair and true if it was inserted.
+     */
+    std::pair<Value *, bool> tryEmplace(std::uint64_t a, std::uint64_t b)
+    {
+        if ((_size + 1) * 2 > _entries.size())
+        {
+            rehash(_entries.empty() ? 16 : _entries.size() * 2);
+        }
+        normalize(a, b);
+        const std::size_t index = lookup(a, b);
+        entry &current = _entries[index];
+        if (current.used)
+        {
+            return {&current.value, false};
+        }
+        current.first = a;
+        current.second = b;
+        current.used = true;
+        ++_size;
+        return {&current.value, true};
+    }
+
+    /**
+     * Removes a pair.
+     * @return true if it was present.
+     */
+    bool erase(std::uint64_t a, std::uint64_t b)
+    {
+        if (_size == 0)
+        {
+            return false;
+        }
+        normalize(a, b);
+        std::size_t hole = lookup(a, b);
+        if (!_entries[hole].used)
+        {
+            return false;
+        }
+
+        // Backward shift, moves back every following entry whose probe sequence goes through the hole
+        const std::size_t mask = _entries.size() - 1;
+        for (std::size_t next = (hole + 1) & mask; _entries[next].used; next = (next + 1) & mask)
+        {
+            const std::size_t home = hash(_entries[next].first, _entries[next].second) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask))
+            {
+                _entries[hole] = std::move(_entries[next]);
+                hole = next;
+            }
+        }
+        _entries[hole] = entry{};
+        --_size;
+        return true;
+    }
+
+    /**
+     * Removes all the pairs keeping the memory.
+     */
+    void clear()
+    {
+        for (entry &current : _entries)
+        {
+            current = entry{};
+        }
+        _size = 0;
+    }
+
+    /**
+     * Calls callback(first, second, value) for every pair, on no particular order. The map must not be modified
+     * inside the callback.
+     */
+    template <typename Callback> void forEach(Callback &&callback)
+    {
+        for (entry &current : _entries)
+        {
+            if (current.used)
+            {
+                callback(current.first, current.second, current.value);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return _size;
+    }
+
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return _entries.size();
+    }
+
+  private:
+    std::vector<entry> _entries; ///< Size is always 0 or a power of two.
+    std::size_t _size = 0;
+
+    static void normalize(std::uint64_t &a, std::uint64_t &b)
+    {
+        if (b < a)
+        {
+            std::swap(a, b);
+        }
+    }
+
+    static std::size_t hash(const std::uint64_t first, const std::uint64_t second)
+    {
+        std::uint64_t value = first * 0x9E3779B97F4A7C15ull ^ second * 0xC2B2AE3D27D4EB4Full;
+        value ^= value >> 32;
+        return static_cast<std::size_t>(value);
+    }
+
+    /**
+     * @return index of the pair, or of the free entry where it would be inserted.
+     */
+    std::size_t lookup(const std::uint64_t first, const std::uint64_t second) const
+    {
+        const std::size_t mask = _entries.size() - 1;
+        std::size_t index = hash(first, second) & mask;
+        while (_entries[index].used && (_entries[index].first != first || _entries[index].second != second))
+        {
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void rehash(const std::size_t capacity)
+    {
+        std::vector<entry> old = std::move(_entries);
+        _entries.clear();
+        _entries.resize(capacity);
+        for (entry &current : old)
+        {
+            if (current.used)
+            {
+                _entries[lookup(current.first, current.second)] = std::move(current);
+            }
+        }
+    }
+};
+} // namespace mate
+
+#endif // GDMATE_PAIRMAP_H
@@ -0,0 +1,144 @@
+/**
+ * @brief RoomArena and ArenaAllocator classes declaration.
+ * @file
+ */
+
+#ifndef GDMATE_ROOMARENA_H
+#define GDMATE_ROOMARENA_H
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Size class pools for the Elements and Components of a Room.
+ *
+ * Every allocation is rounded up to the smallest size class that fits it and served from a free list of blocks of
+ * that class, carved from chunks that are only given back to the system when the arena is destroyed. Allocations
+ * bigger than the largest class, or with a stricter alignment than std::max_align_t, go to the global operator new.
+ *
+ * The arena is shared by the ArenaAllocator of every object allocated from it, so it is freed in bulk once the Room
+ * and every object of the Room are gone. It is not synchronized: objects must be created and destroyed on one thread
+ * at a time.
+ */
+class RoomArena
+{
+  public:
+    static constexpr std::size_t size_classes[] = {32, 64, 128, 256, 512, 1024, 2048};
+    static constexpr std::size_t chunk_bytes = 64 * 1024;
+
+    RoomArena();
+    RoomArena(const RoomArena &) = delete;
+    RoomArena &operator=(const RoomArena &) = delete;
+
+    void *allocate(std::size_t bytes, std::size_t alignment);
+    void deallocate(void *pointer, std::size_t bytes, std::size_t alignment) noexcept;
+
+    /**
+     * @return blocks currently given by the pools, not counting the ones that went to the global operator new.
+     */
+    [[nodiscard]] std::size_t getUsedBlocks() const
+    {
+        return _used_blocks;
+    }
+
+    /**
+     * @return bytes taken from the system by the pools.
+     */
+    [[nodiscard]] std::size_t getReservedBytes() const
+    {
+        return _chunks.size() * chunk_bytes;
+    }
+
+  private:
+    struct free_block
+    {
+        free_block *next;
+    };
+
+    struct pool
+    {
+        std::size_t block_size = 0;
+        free_block *free_list = nullptr;
+    };
+
+    pool _pools[std::size(size_classes)];
+    std::vector<std::unique_ptr<std::byte[]>> _chunks;
+    std::size_t _used_blocks = 0;
+
+    /**
+     * @return pool serving allocations of bytes, nullptr if they are too big for every size class.
+     */
+    pool *findPool(std::size_t bytes, std::size_t alignment);
+
+    /**
+     * Splits a new chunk into blocks for pool.
+     */
+    void refill(pool &pool);
+};
+
+/**
+ * @brief Standard allocator over a RoomArena.
+ *
+ * Used with std::allocate_shared the object and its control block share one pooled block, and the shared_ptr keeps
+ * the arena alive through the allocator stored on its control block. A default constructed allocator has no arena and
+ * uses the global operator new.
+ * @tparam T allocated type.
+ */
+template <class T> class ArenaAllocator
+{
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() = default;
+
+    explicit ArenaAllocator(std::shared_ptr<RoomArena> arena) : _arena(std::move(arena))
+    {
+    }
+
+    template <class U> ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other.getArena())
+    {
+    }
+
+    T *allocate(std::size_t count)
+    {
+        if (!_arena)
+        {
+            return std::allocator<T>().allocate(count);
+        }
+        return static_cast<T *>(_arena->allocate(count * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *pointer, std::size_t count) noexcept
+    {
+        if (!_arena)
+        {
+            std::allocator<T>().deallocate(pointer, count);
+            return;
+        }
+        _arena->deallocate(pointer, count * sizeof(T), alignof(T));
+    }
+
+    [[nodiscard]] const std::shared_ptr<RoomArena> &getArena() const
+    {
+        return _arena;
+    }
+
+    template <class U> bool operator==(const ArenaAllocator<U> &other) const
+    {
+        return _arena == other.getArena();
+    }
+
+  private:
+    std::shared_ptr<RoomArena> _arena;
+};
+} // namespace mate
+
+#endif // GDMATE_ROOMARENA_H
@@ -0,0 +1,93 @@
+/**
+ * @brief SpatialHash class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_SPATIALHASH_H
+#define GDMATE_SPATIALHASH_H
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Uniform grid broad-phase.
+ *
+ * SpatialHash buckets axis aligned bounding boxes into square cells of a fixed size, so superposition candidates for a
+ * box are only the entries that share at least one cell with it. Entries are identified by an id chosen by the user
+ * (usually an index into an external array). Bounds are treated as closed intervals, so boxes that only touch on an
+ * edge still share a cell.
+ *
+ * Entries that would cover more than max_cells_per_entry cells (or that have non finite bounds) are kept on a separate
+ * list and returned by every query, this keeps huge boxes from flooding the grid.
+ */
+class SpatialHash
+{
+  public:
+    static constexpr long max_cells_per_entry = 256;
+
+    explicit SpatialHash(float cell_size = 64.0f);
+
+    /**
+     * Changing the cell size invalidates the stored entries, so the hash is cleared.
+     * @param cell_size side of the square cells, non positive values are ignored.
+     */
+    void setCellSize(float cell_size);
+
+    [[nodiscard]] float getCellSize() const
+    {
+        return _cell_size;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return _ids.size();
+    }
+
+    /**
+     * Removes all entries. Cell buckets that were used since the previous clear keep their memory so rebuilding the
+     * hash every frame does not reallocate.
+     */
+    void clear();
+
+    /**
+     * Adds an entry to every cell touched by bounds.
+     * @param id value returned by query() for this entry.
+     * @param bounds world space bounding box, width and height are expected to be non negative.
+     */
+    void insert(unsigned int id, const sf::FloatRect &bounds);
+
+    /**
+     * Collects the ids of all the entries sharing a cell with bounds.
+     * @param bounds world space bounding box, width and height are expected to be non negative.
+     * @param result cleared and filled with the candidate ids, sorted in ascending order and without duplicates.
+     */
+    void query(const sf::FloatRect &bounds, std::vector<unsigned int> &result) const;
+
+  private:
+    float _cell_size;
+    std::unordered_map<std::uint64_t, std::vector<unsigned int>> _cells;
+    std::vector<unsigned int> _oversized; ///< Entries too big (or invalid) to be bucketed.
+    std::vector<unsigned int> _ids;       ///< Every inserted id, returned when the query itself is oversized.
+
+    struct cell_range
+    {
+        std::int32_t min_x, min_y, max_x, max_y;
+    };
+
+    /**
+     * @return false if bounds is not finite or covers more than max_cells_per_entry cells.
+     */
+    bool getCellRange(const sf::FloatRect &bounds, cell_range &range) const;
+
+    static std::uint64_t getKey(std::int32_t x, std::int32_t y)
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) | static_cast<std::uint32_t>(y);
+    }
+};
+} // namespace mate
+
+#endif // GDMATE_SPATIALHASH_H
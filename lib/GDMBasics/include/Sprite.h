@@ -22,11 +22,25 @@ class Sprite : public Component
   private:
     sf::Texture _texture;
     std::shared_ptr<ord_sprite> _sprite;
-    std::weak_ptr<Game> _game_manager;
 
     bool _actualize = true;
 
+    // World transform of the last two loops, blended by renderLoop()
+    bool _interpolate = true;
+    bool _has_previous = false; ///< False until the second loop() after a resetInterpolation().
+    sf::Vector2f _previous_position;
+    sf::Vector2f _current_position;
+    sf::Vector2f _previous_scale{1, 1};
+    sf::Vector2f _current_scale{1, 1};
+    float _previous_rotation = 0;
+    float _current_rotation = 0;
+
   public:
+    /// Kept on the Room's ComponentTable when the Room uses a ComponentStorage.
+    static constexpr bool component_system = true;
+    /// loop() only reads the world coordinates of its Element.
+    static constexpr ThreadAffinity thread_affinity = ANY_THREAD;
+
     Bounds offset;
     // Constructor
     explicit Sprite(const std::weak_ptr<Element> &parent);
@@ -76,9 +90,9 @@ class Sprite : public Component
      */
     [[maybe_unused]] int getElementDepth() const
     {
-        if (auto spt_parent = _parent.lock())
+        if (const LocalCoords *parent = getParentCoords())
         {
-            return spt_parent->depth;
+            return parent->depth;
         }
         return INT_MIN;
     }
@@ -96,6 +110,24 @@ class Sprite : public Component
         _actualize = actualize;
     }
 
+    /**
+     * @param interpolate if true, the default, renderLoop() draws the Sprite between the transforms of the last two
+     * loops according to ILoop::getInterpolation(), otherwise it's drawn on the last one.
+     */
+    [[maybe_unused]] void setInterpolation(bool interpolate)
+    {
+        _interpolate = interpolate;
+    }
+
+    /**
+     * Makes the next loop() start the interpolation from scratch, for Elements that jump instead of moving, like the
+     * ones spawned again by an ElementPool.
+     */
+    [[maybe_unused]] void resetInterpolation()
+    {
+        _has_previous = false;
+    }
+
     // Other methods declarations
     /**
      * Adds a value to the Sprite's depth. If the result exceeds the valid limits the result will remain at
@@ -107,6 +139,10 @@ class Sprite : public Component
      * the associated Element.
      */
     void loop() override;
+    /**
+     * Places the printed image between the transforms of the last two loops, see setInterpolation().
+     */
+    void renderLoop() override;
 };
 } // namespace mate
 
@@ -0,0 +1,158 @@
+/**
+ * @brief StaticTree class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_STATICTREE_H
+#define GDMATE_STATICTREE_H
+
+#include "NarrowPhase.h"
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Immutable bounding volume hierarchy for entries that never move.
+ *
+ * The whole tree is built at once splitting the entries by the median of their centers on the longest axis, so it's
+ * balanced and doesn't need any of the bookkeeping of DynamicTree. Nodes are packed on a single array in depth first
+ * order with the left child right after its parent, and the entries of every leaf are contiguous, which keeps queries
+ * cache friendly. Changing anything requires building the tree again.
+ *
+ * Bounds are treated as closed intervals, boxes touching on an edge overlap.
+ */
+class StaticTree
+{
+  public:
+    struct item
+    {
+        sf::FloatRect bounds;
+        int id;
+    };
+
+    /**
+     * Replaces the content of the tree.
+     * @param items entries of the tree, width and height of their bounds are expected to be non negative.
+     */
+    void build(std::vector<item> items);
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return _items.size();
+    }
+
+    /**
+     * Calls callback(id) for every entry whose bounds overlap bounds.
+     */
+    template <typename Callback> void query(const sf::FloatRect &bounds, Callback &&callback) const
+    {
+        if (_nodes.empty())
+        {
+            return;
+        }
+        const float min_x = bounds.left;
+        const float max_x = bounds.left + bounds.width;
+        const float min_y = bounds.top;
+        const float max_y = bounds.top + bounds.height;
+
+        // The tree is balanced, so its depth stays far below the stack size
+        int stack[64];
+        int stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const int index = stack[--stack_size];
+            const node &current = _nodes[index];
+            if (current.min_x > max_x || min_x > current.max_x || current.min_y > max_y || min_y > current.max_y)
+            {
+                continue;
+            }
+            if (current.count > 0)
+            {
+                for (int i = current.first; i < current.first + current.count; ++i)
+                {
+                    const sf::FloatRect &other = _items[i].bounds;
+                    if (other.left <= max_x && min_x <= other.left + other.width && other.top <= max_y &&
+                        min_y <= other.top + other.height)
+                    {
+                        callback(_items[i].id);
+                    }
+                }
+            }
+            else
+            {
+                stack[stack_size++] = current.first;
+                stack[stack_size++] = index + 1;
+            }
+        }
+    }
+
+    /**
+     * Calls callback(id) for every entry whose bounds are hit by a ray. The callback returns the new length of the
+     * ray, returning a shorter one skips the entries that are farther away.
+     * @param direction normalized direction of the ray.
+     */
+    template <typename Callback>
+    void raycast(const sf::Vector2f origin, const sf::Vector2f direction, float max_distance,
+                 Callback &&callback) const
+    {
+        if (_nodes.empty())
+        {
+            return;
+        }
+        int stack[64];
+        int stack_size = 0;
+        stack[stack_size++] = 0;
+        while (stack_size > 0)
+        {
+            const int index = stack[--stack_size];
+            const node &current = _nodes[index];
+            float distance;
+            if (!rayToBoxCheck(origin, direction, max_distance, current.min_x, current.min_y, current.max_x,
+                               current.max_y, distance))
+            {
+                continue;
+            }
+            if (current.count > 0)
+            {
+                for (int i = current.first; i < current.first + current.count; ++i)
+                {
+                    const sf::FloatRect &bounds = _items[i].bounds;
+                    if (rayToBoxCheck(origin, direction, max_distance, bounds.left, bounds.top,
+                                      bounds.left + bounds.width, bounds.top + bounds.height, distance))
+                    {
+                        max_distance = callback(_items[i].id);
+                    }
+                }
+            }
+            else
+            {
+                stack[stack_size++] = current.first;
+                stack[stack_size++] = index + 1;
+            }
+        }
+    }
+
+  private:
+    static constexpr int leaf_size = 4;
+
+    struct node
+    {
+        float min_x, min_y, max_x, max_y;
+        int first; ///< First item of a leaf, or index of the right child.
+        int count; ///< Items of a leaf, 0 for inner nodes.
+    };
+
+    std::vector<node> _nodes;
+    std::vector<item> _items;
+
+    /**
+     * Builds the subtree of the items in [begin, end).
+     * @return index of the subtree root.
+     */
+    int buildNode(int begin, int end);
+};
+} // namespace mate
+
+#endif // GDMATE_STATICTREE_H
@@ -0,0 +1,104 @@
+/**
+ * @brief SweepAndPrune class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_SWEEPANDPRUNE_H
+#define GDMATE_SWEEPANDPRUNE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Sort and sweep broad-phase with temporal coherence.
+ *
+ * SweepAndPrune keeps its entries sorted by the left side of their bounds. The order is kept between updates and
+ * restored with an insertion sort, so when entries only move a little between frames the update cost is close to
+ * linear and grows with the amount of movement. Entries inserted since the last update are sorted on their own and
+ * merged instead, so bursts of insertions stay O(n log n). Pairs are found sweeping the sorted array, comparing every
+ * entry with the following ones until their left side goes past its right side, and optionally rejecting the pairs
+ * that don't overlap on the vertical axis too.
+ *
+ * Entries are identified by a non negative id chosen by the user. Bounds are treated as closed intervals.
+ */
+class SweepAndPrune
+{
+  public:
+    /**
+     * Adds an entry, it's placed on its sorted position on the next update().
+     */
+    void insert(int id, const sf::FloatRect &bounds);
+
+    /**
+     * Removes an entry, the array is compacted on the next update() or once most of its entries are removed, so
+     * inserting and removing without updates doesn't grow it forever.
+     */
+    void remove(int id);
+
+    /**
+     * Changes the bounds of an entry, the order is restored on the next update().
+     */
+    void setBounds(int id, const sf::FloatRect &bounds);
+
+    /**
+     * Drops the removed entries, restores the order of the existing ones with an insertion sort and merges the new
+     * ones.
+     * @return amount of swaps performed by the insertion sort, useful to measure how coherent the movement was.
+     */
+    unsigned long update();
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return _entries.size() - _removed_count;
+    }
+
+#ifdef GDM_TESTING_ENABLED
+    /**
+     * @return entries on the array, removed ones included.
+     */
+    [[nodiscard]] std::size_t getStoredCount() const
+    {
+        return _entries.size();
+    }
+#endif
+
+    /**
+     * Calls callback(id_a, id_b) once for every pair of entries whose bounds overlap on the horizontal axis (and on
+     * the vertical one if second_axis is true). Expects update() to be called after the last change.
+     */
+    template <typename Callback> void queryPairs(bool second_axis, Callback &&callback) const
+    {
+        for (auto a = _entries.begin(); a != _entries.end(); ++a)
+        {
+            for (auto b = a + 1; b != _entries.end() && b->min_x <= a->max_x; ++b)
+            {
+                if (!second_axis || (a->min_y <= b->max_y && b->min_y <= a->max_y))
+                {
+                    callback(a->id, b->id);
+                }
+            }
+        }
+    }
+
+  private:
+    struct entry
+    {
+        float min_x, max_x, min_y, max_y;
+        int id; ///< -1 once removed.
+    };
+
+    std::vector<entry> _entries;
+    std::vector<int> _positions; ///< Index on _entries of every id, -1 if the id is not in use.
+    std::size_t _removed_count = 0;
+    std::size_t _sorted_count = 0; ///< Entries placed by the last update(), the ones after them were inserted later.
+
+    /**
+     * Drops the removed entries keeping the order of the rest.
+     */
+    void compact();
+};
+} // namespace mate
+
+#endif // GDMATE_SWEEPANDPRUNE_H
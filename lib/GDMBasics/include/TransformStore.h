@@ -0,0 +1,193 @@
+/**
+ * @brief TransformStore class and transform_buffer structure declaration.
+ * @file
+ */
+
+#ifndef GDMATE_TRANSFORMSTORE_H
+#define GDMATE_TRANSFORMSTORE_H
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Structure of arrays with the 2D affine matrices, scales and rotations of a set of transforms.
+ *
+ * Only the six meaningful values of every matrix are kept, m<row><column> of the sf::Transform 3x3 matrix.
+ */
+struct transform_buffer
+{
+    std::vector<float> m00;
+    std::vector<float> m01;
+    std::vector<float> m02;
+    std::vector<float> m10;
+    std::vector<float> m11;
+    std::vector<float> m12;
+    std::vector<float> scale_x;
+    std::vector<float> scale_y;
+    std::vector<float> rotation;
+
+    void resize(std::size_t size)
+    {
+        m00.resize(size);
+        m01.resize(size);
+        m02.resize(size);
+        m10.resize(size);
+        m11.resize(size);
+        m12.resize(size);
+        scale_x.resize(size);
+        scale_y.resize(size);
+        rotation.resize(size);
+    }
+
+    void set(std::size_t index, const sf::Transform &transform, sf::Vector2f scale, float angle)
+    {
+        // sf::Transform stores a 4x4 column major matrix
+        const float *matrix = transform.getMatrix();
+        m00[index] = matrix[0];
+        m01[index] = matrix[4];
+        m02[index] = matrix[12];
+        m10[index] = matrix[1];
+        m11[index] = matrix[5];
+        m12[index] = matrix[13];
+        scale_x[index] = scale.x;
+        scale_y[index] = scale.y;
+        rotation[index] = angle;
+    }
+
+    /**
+     * Copies the entry from of buffer into the entry to of this one.
+     */
+    void copy(std::size_t to, const transform_buffer &buffer, std::size_t from)
+    {
+        m00[to] = buffer.m00[from];
+        m01[to] = buffer.m01[from];
+        m02[to] = buffer.m02[from];
+        m10[to] = buffer.m10[from];
+        m11[to] = buffer.m11[from];
+        m12[to] = buffer.m12[from];
+        scale_x[to] = buffer.scale_x[from];
+        scale_y[to] = buffer.scale_y[from];
+        rotation[to] = buffer.rotation[from];
+    }
+
+    [[nodiscard]] sf::Transform getTransform(std::size_t index) const
+    {
+        return {m00[index], m01[index], m02[index], m10[index], m11[index], m12[index], 0, 0, 1};
+    }
+};
+
+/**
+ * @brief Flat storage for the local and world transforms of a hierarchy.
+ *
+ * Every node is identified by a stable id, while its transforms live on contiguous arrays where every parent comes
+ * before its children. update() computes all the world transforms in one linear pass where every node only reads the
+ * already computed world transform of its parent, instead of following pointers up the hierarchy.
+ *
+ * Only the positions from the first changed one on are recomputed, and the world getters stop at the node they read,
+ * so moving and reading the nodes one after another in the order of the arrays still costs a single pass.
+ *
+ * Structural changes are cheap: new nodes are appended (their parent is always before them) and removed nodes are
+ * left as holes, the arrays are only reordered on the next update() after a removal or after moving a node below one
+ * that comes later.
+ *
+ * LocalCoords can use a TransformStore as its storage, see LocalCoords::useTransformStore().
+ */
+class TransformStore
+{
+  public:
+    /**
+     * Adds a node with an identity local transform.
+     * @param parent id of the parent node, -1 for a root.
+     * @return id of the new node.
+     */
+    int add(int parent = -1);
+
+    /**
+     * Removes a node, its id may be reused after the next update(). Its children must be removed or moved to another
+     * parent first.
+     */
+    void remove(int node);
+
+    /**
+     * @param parent id of the new parent node, -1 to make the node a root.
+     */
+    void setParent(int node, int parent);
+
+    /**
+     * Sets the local transform of a node, along with the scale and rotation it was built from.
+     */
+    void setLocal(int node, const sf::Transform &transform, sf::Vector2f scale, float rotation);
+
+    /**
+     * Reorders the arrays if needed and recomputes the world transforms from the first position that changed since
+     * the last call. The world getters do the same, up to the node they read.
+     */
+    void update();
+
+    /**
+     * @return parent's world transform * local transform.
+     */
+    sf::Transform getWorldTransform(int node);
+
+    /**
+     * @return local position transformed by the parent's world transform.
+     */
+    sf::Vector2f getWorldPosition(int node);
+
+    /**
+     * @return local scale * parent's world scale.
+     */
+    sf::Vector2f getWorldScale(int node);
+
+    /**
+     * @return local rotation + parent's world rotation.
+     */
+    float getWorldRotation(int node);
+
+    /**
+     * @return amount of nodes on the store.
+     */
+    [[nodiscard]] std::size_t size() const
+    {
+        return _ids.size() - _holes;
+    }
+
+  private:
+    // Indexed by position on the arrays
+    transform_buffer _local;
+    transform_buffer _world;
+    std::vector<int> _parents; ///< Position of the parent, -1 for roots.
+    std::vector<int> _ids;     ///< Node on every position, -1 for removed ones.
+
+    // Indexed by node id
+    std::vector<int> _positions;    ///< Position of every node on the arrays, -1 for free ids.
+    std::vector<int> _parent_ids;   ///< Parent of every node, -1 for roots.
+    std::vector<int> _free_ids;     ///< Ids ready to be reused.
+    std::vector<int> _released_ids; ///< Removed ids, freed on the next reorder since their positions are still holes.
+
+    std::size_t _holes = 0;
+    bool _order_dirty = false; ///< The arrays have holes or a node is placed before its parent.
+    /// First position whose world transform may be outdated, the ones before it are up to date.
+    std::size_t _dirty_from = 0;
+
+    /**
+     * Rebuilds the arrays in depth first order, without holes.
+     */
+    void reorder();
+
+    /**
+     * Recomputes the world transforms of the outdated positions before end.
+     */
+    void computeWorld(std::size_t end);
+
+    /**
+     * Reorders the arrays if needed and computes the world transform of a node and its ancestors.
+     * @return position of the node.
+     */
+    int updateNode(int node);
+};
+} // namespace mate
+
+#endif // GDMATE_TRANSFORMSTORE_H
@@ -7,56 +7,378 @@
 #define TRIGGER_H
 
 #include "Basics.h"
-#include <list>
+#include "DynamicTree.h"
+#include "NarrowPhase.h"
+#include "PairMap.h"
+#include "SpatialHash.h"
+#include "StaticTree.h"
+#include "SweepAndPrune.h"
+#include "WorkerPool.h"
 #include <memory>
+#include <vector>
 
 namespace mate {
 
-	/// Shapes supported for trigger detection
-	enum ShapeType
+	/**
+	 * @brief Registry and collision data of the Triggers of a Room.
+	 *
+	 * Every Room creates its own world when the first of its Triggers subscribes and destroys it with the Room, so
+	 * Triggers of different Rooms never check each other and only the Triggers of the Rooms being run are touched.
+	 * Subscribed Triggers are identified by a proxy, an index on proxy_entries reused once the Trigger unsubscribes,
+	 * which makes subscribing, unsubscribing and looking a Trigger up by its handle O(1).
+	 */
+	struct trigger_world
 	{
-		RECTANGLE, ///< Calculated from the top left corner + height/width
-		CIRCLE ///< Calculated from center + radius [max dimension]
+		/// Data of a subscribed Trigger indexed by proxy. Proxies are also the ids used on sweep_and_prune,
+		/// broad_phase and static_tree.
+		struct proxy_entry
+		{
+			std::weak_ptr<Trigger> trigger;
+			std::uint32_t generation = 0; ///< Increased when the proxy is released, invalidates the old handles.
+			int slot = -1;                ///< Position on subscribed.
+			bool is_static = false;
+			/// Leaf on broad_phase_tree, DynamicTree::null_node for static Triggers.
+			int leaf = DynamicTree::null_node;
+			unsigned long order = 0;           ///< Subscription order.
+			std::uint32_t category = 0;        ///< Copied when the broad-phase is built.
+			std::uint32_t collision_mask = 0;  ///< Copied when the broad-phase is built.
+			bool moved = false;                ///< Queued on moved_proxies.
+		};
+
+		/// Superposed pair of Triggers, first is the one subscribed first.
+		struct contact
+		{
+			std::weak_ptr<Trigger> first;
+			std::weak_ptr<Trigger> second;
+			unsigned long frame; ///< Last frame in which the pair was superposed.
+		};
+
+		/// Per thread buffers of the narrow-phase.
+		struct narrow_phase_buffer
+		{
+			std::vector<int> candidates; ///< Sent to shapesBatchCheck().
+			std::vector<int> hits;
+			std::vector<std::pair<int, int>> contacts; ///< Superposed pairs found by the thread.
+		};
+
+		/// Copied from the Room before its Elements loop.
+		trigger_settings settings{};
+
+		std::vector<proxy_entry> proxy_entries;
+		/// Proxies of the subscribed Triggers in subscription order, -1 for the ones that unsubscribed since the last
+		/// time the broad-phase was built.
+		std::vector<int> subscribed;
+		/// Proxies not in use.
+		std::vector<int> free_proxies;
+		/// Proxies released since the broad-phase was built. They are only reused after the next build so the pairs
+		/// of the current one never point to another Trigger.
+		std::vector<int> released_proxies;
+		/// Amount of subscriptions ever made, used to give every subscription an order value.
+		unsigned long subscriptions_count = 0;
+
+		/// Bounding volume hierarchy with the dynamic active Triggers, kept up to date on subscription.
+		DynamicTree broad_phase_tree;
+		/// Proxy of every broad_phase_tree leaf.
+		std::vector<int> leaf_proxies;
+		/// Sorted bounds of the dynamic active Triggers, kept up to date on subscription.
+		SweepAndPrune sweep_and_prune;
+		/// Uniform grid with the bounds of the active Triggers, ids are proxies.
+		SpatialHash broad_phase;
+		/// Reused buffer for the broad_phase queries, also used as cursor while grouping the pairs.
+		std::vector<unsigned int> broad_phase_candidates;
+
+		/// Bounds of the static active Triggers, queried by the dynamic ones.
+		StaticTree static_tree;
+		/// Set when a static Trigger subscribes, unsubscribes or changes.
+		bool static_dirty = true;
+
+		/// Candidate pairs found by the broad-phase before being grouped by proxy, the first proxy of every pair is the
+		/// one subscribed first.
+		std::vector<std::pair<int, int>> proxy_pairs_buffer;
+		/// Candidates of every proxy subscribed after it, the ones of proxy p are on
+		/// [proxy_pairs_offsets[p], proxy_pairs_offsets[p+1]).
+		std::vector<int> proxy_pairs;
+		std::vector<unsigned int> proxy_pairs_offsets;
+		/// Set when the broad-phase no longer matches the subscribed Triggers (new frame, subscriptions, etc).
+		bool broad_phase_dirty = true;
+		/// Settings the broad-phase was last built with.
+		trigger_settings built_settings{};
+		/// Set when shapes and broad_phase_tree may no longer match the active Triggers (new tick, subscriptions, etc),
+		/// the spatial queries refresh them before using them. Cleared by DYNAMIC_TREE builds, which refresh both.
+		bool query_tree_dirty = true;
+		/// Dynamic Triggers moved since shapes and broad_phase_tree were refreshed, only tracked while at least one of
+		/// them is up to date.
+		std::vector<int> moved_proxies;
+		/// Set when a Trigger moved after the pairs were built, the Triggers that check after it query broad_phase_tree
+		/// instead of using the pairs until the next build.
+		bool pairs_stale = false;
+		/// Reused buffer for the queries of those Triggers.
+		std::vector<int> stale_candidates;
+
+		/// Position, dimensions and shape of every active Trigger indexed by proxy, taken when the broad-phase is
+		/// built.
+		shape_buffer shapes;
+		/// Checked state of every active Trigger indexed by proxy, rejects candidates without touching the Triggers.
+		std::vector<std::uint8_t> proxy_checked;
+		/// Threads running the narrow-phase.
+		WorkerPool narrow_phase_pool;
+		std::vector<narrow_phase_buffer> narrow_phase_buffers;
+		/// Superposed pairs found by all the threads before being grouped by proxy.
+		std::vector<std::pair<int, int>> contact_pairs_buffer;
+		/// Superposed Triggers of every proxy, same layout as proxy_pairs.
+		std::vector<int> contact_pairs;
+		std::vector<unsigned int> contact_pairs_offsets;
+
+		/// Pairs superposed on the current or the previous frame, keyed by subscription order.
+		PairMap<contact> contacts;
+		/// Reused buffer with the pairs that stopped being superposed.
+		std::vector<PairMap<contact>::entry> ended_contacts;
+		/// Current contacts frame, one per Room::loop(). Triggers are checked once per frame.
+		unsigned long contacts_frame = 0;
+		/// Cleared by loop, the end of the tick closes the frame and fires the onExit events.
+		bool contacts_frame_ended = true;
+		/// Set on the worlds of a Room, which ends their ticks at the end of every loop(). Other worlds end them on
+		/// renderLoop.
+		bool room_owned = false;
 	};
 
 	/**
 	 * @brief Superposition detection component.
 	 *
 	 * Triggers are a component type that executes tasks when they are superposed by another Trigger.
+	 *
+	 * Triggers whose hierarchy doesn't end on a Room share the world of the thread that subscribed them, which isn't
+	 * synchronized. They are confined to that thread: subscribing, unsubscribing, looping and destroying them from any
+	 * other thread is a data race.
 	 */
 	class Trigger : public Component, public std::enable_shared_from_this<Trigger>
 	{
 	private:
-		/// Used to know when a Trigger has already made it's superposition checks.
-		bool checked;
+		/// Contacts frame in which the Trigger made its superposition checks, see checkedOn().
+		unsigned long checked_frame = no_frame;
+		static constexpr unsigned long no_frame = ~0UL;
 
 		bool active;
+		/// The Trigger was active when its Element went back to its pool, it subscribes again on onWake().
+		bool active_before_sleep = false;
+		/// Static Triggers are expected to never move, see setStatic().
+		bool is_static = false;
 		ShapeType shape{};
+		/// Subscription order of the current subscription, identifies the Trigger on contacts.
+		unsigned long order = 0;
+		/// Layers the Trigger belongs to, one per bit.
+		std::uint32_t category = 1;
+		/// Layers the Trigger can be superposed with.
+		std::uint32_t collision_mask = 0xFFFFFFFF;
+
+		/// Collision world the Trigger subscribed to, kept after unsubscribing so it can still close the frames.
+		std::weak_ptr<trigger_world> world;
+		/// Handle of the current subscription, only valid while active.
+		trigger_handle handle;
+		/// World of the Triggers whose hierarchy doesn't end on a Room, one per thread so Games on different threads
+		/// never share it. Not synchronized, a Trigger subscribed to it must be released on the same thread.
+		static thread_local std::shared_ptr<trigger_world> detached_world;
 
-		/// List of existing subscribed (active) Triggers. This are the Triggers that will be checked for superposition.
-		static std::list<std::weak_ptr<Trigger>> active_triggers;
+		/**
+		 * runs a loop to check superposition with all the active Triggers of its world, using the broad-phase selected
+		 * on the Room that holds this Trigger.
+		 */
+		void runChecks(trigger_world &world);
+
+		/**
+		 * @return true if the Trigger already made its superposition checks on the current frame of world.
+		 */
+		[[nodiscard]] bool checkedOn(const trigger_world &world) const
+		{
+			return checked_frame == world.contacts_frame;
+		}
+
+		/**
+		 * Reference broad-phase, checks superposition against every active Trigger.
+		 */
+		void runBruteForceChecks(trigger_world &world);
+
+		/**
+		 * Fires the contacts of this Trigger on contact_pairs. The contacts of all Triggers are found at once, on the
+		 * first call of every tick and again whenever a Trigger subscribes or unsubscribes. Once a Trigger moves after
+		 * that the pairs no longer match the current positions, and the remaining Triggers of the tick use
+		 * runStaleChecks() instead.
+		 */
+		void runBroadPhaseChecks(trigger_world &world);
+
+		/**
+		 * Queries broad_phase_tree and static_tree with the current bounds of this Trigger and checks the candidates
+		 * like runBruteForceChecks() does, on the same order.
+		 */
+		void runStaleChecks(trigger_world &world);
+
+		/**
+		 * Queues the proxy on moved_proxies, unless the next build or refresh already covers it.
+		 */
+		static void markMoved(trigger_world &world, int proxy);
+
+		/**
+		 * Executed when the bounds of the Trigger change, see markMoved().
+		 */
+		void boundsChanged();
+
+		/**
+		 * Drops the unsubscribed Triggers from subscribed, copies the shapes of the active ones into shapes, updates
+		 * the selected broad-phase with their bounds, fills proxy_pairs with the candidates of every Trigger and runs
+		 * the narrow-phase. SPATIAL_HASH queries the grid once per Trigger, DYNAMIC_TREE does a single tree against
+		 * tree traversal and SWEEP_AND_PRUNE a single sweep.
+		 */
+		static void buildBroadPhase(trigger_world &world);
+
+		/**
+		 * Runs buildBroadPhase() if the broad-phase is dirty or was built with other settings.
+		 */
+		static void updateBroadPhase(trigger_world &world);
+
+		/**
+		 * Refreshes shapes, broad_phase_tree and static_tree with the active Triggers, whatever the broad-phase
+		 * selected, once per tick and after subscriptions, and with the Triggers on moved_proxies. Never builds the
+		 * pairs or runs the narrow-phase, so queries made from a loop() don't change the contacts of the tick.
+		 */
+		static void prepareQueries(trigger_world &world);
+
+		/**
+		 * Filters a spatial query candidate that already passed the shape test.
+		 * @param trigger set to the candidate's Trigger.
+		 * @return true if the Trigger is alive and active and its category matches mask.
+		 */
+		static bool acceptQueryHit(const trigger_world &world, int proxy, std::uint32_t mask,
+		                           std::shared_ptr<Trigger> &trigger);
+
+		static void sortByOrder(std::vector<std::shared_ptr<Trigger>> &triggers);
+
+		/**
+		 * Checks the candidates on proxy_pairs with shapesBatchCheck() and fills contact_pairs with the superposed
+		 * ones. The work is split across narrow_phase_pool without side effects, every thread writes on its own buffer
+		 * and the buffers are merged and sorted afterwards, so the result is the same for any amount of threads.
+		 * fireTrigger is only called later, on the calling thread, by runBroadPhaseChecks.
+		 */
+		static void runNarrowPhase(trigger_world &world);
+
+		/**
+		 * Copies the shapes of the static Triggers into shapes and builds static_tree with their bounds.
+		 */
+		static void buildStaticIndex(trigger_world &world);
+
+		/**
+		 * Adds a proxy to broad_phase_tree and sweep_and_prune.
+		 */
+		static void insertDynamicProxy(trigger_world &world, int proxy, const sf::FloatRect &bounds);
+
+		/**
+		 * Removes a proxy from broad_phase_tree and sweep_and_prune.
+		 */
+		static void removeDynamicProxy(trigger_world &world, int proxy);
+
+		/**
+		 * Adds the pair to proxy_pairs_buffer if the layers of both proxies allow them to be superposed.
+		 */
+		static void addProxyPair(trigger_world &world, int proxy_a, int proxy_b);
+
+		/**
+		 * Groups a list of pairs by proxy.
+		 * @param symmetric if false pairs are only added to the group of their first proxy, if true they are added to
+		 * both groups and every group is sorted by subscription order.
+		 * @param grouped output, the group of proxy p is on [offsets[p], offsets[p+1]).
+		 */
+		static void groupPairs(trigger_world &world, const std::vector<std::pair<int, int>> &pairs, bool symmetric,
+		                       std::vector<int> &grouped, std::vector<unsigned int> &offsets);
+
+		/**
+		 * @return bounds of a shape, same as getBounds().
+		 */
+		static sf::FloatRect shapeBounds(ShapeType shape, sf::Vector2f position, sf::Vector2f dimensions);
 
 		/**
-		 * runs a loop to check superposition with all the active Triggers.
+		 * @return bounds of the shape of a proxy on shapes.
 		 */
-		void runChecks();
+		static sf::FloatRect proxyBounds(const trigger_world &world, int proxy);
+
+		/**
+		 * Removes a proxy from subscribed and from the dynamic structures or the static index. O(1), the slot on
+		 * subscribed is left empty until the next build.
+		 */
+		static void removeProxy(trigger_world &world, int proxy);
+
+		/**
+		 * @return world of the Room at the top of the Trigger's hierarchy, or detached_world if the hierarchy doesn't
+		 * end on a Room.
+		 */
+		[[nodiscard]] std::shared_ptr<trigger_world> findWorld() const;
+
+		/**
+		 * @return Room at the top of the Trigger's hierarchy, empty if the hierarchy doesn't end on a Room.
+		 */
+		[[nodiscard]] std::shared_ptr<Room> getRoom() const;
 
 		/**
 		 * Checks if there is superposition between trigger_a & trigger_b. If there is, it executes both of their
-		 * fireTrigger methods.
+		 * fireTrigger methods. Pairs whose layers don't match and pairs of static Triggers are rejected before
+		 * resolving their world positions.
 		 * @param trigger_a Trigger different from trigger_b
 		 * @param trigger_b Trigger different from trigger_a
 		 */
-		static void checkTrigger(const std::shared_ptr<Trigger>& trigger_a, const std::shared_ptr<Trigger>& trigger_b);
+		static void checkTrigger(trigger_world &world, const std::shared_ptr<Trigger>& trigger_a,
+		                         const std::shared_ptr<Trigger>& trigger_b);
+
+		/**
+		 * Executes the fireTrigger methods of two superposed Triggers, followed by their onEnter methods if they were
+		 * not superposed on the previous frame or their onStay methods otherwise.
+		 */
+		static void fireContact(trigger_world &world, const std::shared_ptr<Trigger>& trigger_a,
+		                        const std::shared_ptr<Trigger>& trigger_b);
+
+		/**
+		 * Fires onExit for the contacts that were not superposed on the frame that just ended, sorted by subscription
+		 * order, and starts a new frame.
+		 */
+		static void endContactsFrame(trigger_world &world);
 	protected:
 		/**
 		 * Executes a particular task that depends on the particular implementation of Trigger.
 		 * @param trigger_by Trigger that's superposed with this one.
 		 */
 		virtual void fireTrigger(const std::shared_ptr<Trigger>& trigger_by) = 0;
+
+		/**
+		 * Executed on the first frame of a superposition, after fireTrigger.
+		 * @param trigger_by Trigger that started being superposed with this one.
+		 */
+		virtual void onEnter([[maybe_unused]] const std::shared_ptr<Trigger>& trigger_by) {}
+
+		/**
+		 * Executed on every following frame of the superposition, after fireTrigger.
+		 * @param trigger_by Trigger that's still superposed with this one.
+		 */
+		virtual void onStay([[maybe_unused]] const std::shared_ptr<Trigger>& trigger_by) {}
+
+		/**
+		 * Executed once the superposition ends, at the end of the first Room::loop() without it. Also executed when
+		 * one of the Triggers unsubscribes or is destroyed.
+		 * @param trigger_by Trigger that was superposed with this one, empty if it no longer exists.
+		 */
+		virtual void onExit([[maybe_unused]] const std::shared_ptr<Trigger>& trigger_by) {}
+
+		/// Unsubscribes the Trigger while its Element waits on its pool.
+		void onSleep() override;
+		/// Subscribes again if the Trigger was active before sleeping.
+		void onWake() override;
 	public:
+		/// Kept on the Room's ComponentTable when the Room uses a ComponentStorage.
+		static constexpr bool component_system = true;
+
 		// Constructor
 		explicit Trigger(const std::weak_ptr<Element> &parent);
+		/// Unsubscribes the Trigger from its world.
+		~Trigger();
+
+		/// Refreshes the Trigger on its world when it moves after the broad-phase was built.
+		void onParentMoved() override;
 
 		/// offset of the Trigger in respect to the Element that holds it.
 		Bounds offset{};
@@ -70,12 +392,44 @@ namespace mate {
 		 * shape setter method
 		 * @param shape New shape of the Trigger
 		 */
-		void setShape(const ShapeType shape) { this->shape = shape; }
+		void setShape(const ShapeType shape)
+		{
+			this->shape = shape;
+			boundsChanged();
+		}
+		/**
+		 * @return true if the Trigger already made its superposition checks on the current tick.
+		 */
+		[[nodiscard]] bool wasChecked() const
+		{
+			const auto current = world.lock();
+			return current && checkedOn(*current);
+		}
+		/**
+		 * @return true if the Trigger was marked as static.
+		 */
+		[[nodiscard]] bool isStatic() const { return is_static; }
+		/**
+		 * @return handle of the current subscription, see Room::findTrigger().
+		 */
+		[[nodiscard]] trigger_handle getHandle() const { return handle; }
+		/**
+		 * @return layers the Trigger belongs to.
+		 */
+		[[nodiscard]] std::uint32_t getCategory() const { return category; }
+		/**
+		 * @return layers the Trigger can be superposed with.
+		 */
+		[[nodiscard]] std::uint32_t getCollisionMask() const { return collision_mask; }
 		/**
-		 * checked getter
-		 * @return checked
+		 * Two Triggers can only be superposed when the category of each one shares a bit with the collision mask of the
+		 * other.
+		 * @return true if the layers of both Triggers allow them to be superposed.
 		 */
-		[[nodiscard]] bool wasChecked() const { return checked; }
+		[[nodiscard]] bool canCollideWith(const Trigger &other) const
+		{
+			return (category & other.collision_mask) != 0 && (other.category & collision_mask) != 0;
+		}
 
 		// Other Methods declarations
 
@@ -91,6 +445,12 @@ namespace mate {
 		 */
 		sf::Vector2f getDimensions() const;
 
+		/**
+		 * World space bounding box of the Trigger's shape, used by the broad-phase.
+		 * @return rectangle with non negative width and height that contains the Trigger's shape.
+		 */
+		[[nodiscard]] sf::FloatRect getBounds() const;
+
 		/**
 		 * Setter for offset scale
 		 * @param width
@@ -106,13 +466,38 @@ namespace mate {
 		void setPosition(float x, float y);
 
 		/**
-		 * Removes the Trigger from the active Triggers list making it so fireTrigger is never executed.
+		 * @brief Marks the Trigger as static (walls, pickup zones, level regions) or dynamic.
+		 *
+		 * Static Triggers are kept on an immutable index built on the first frame (usually when the Room loads) and
+		 * rebuilt only when a static Trigger subscribes, unsubscribes or changes its layers or static state. Only
+		 * dynamic Triggers query it, so pairs of static Triggers are never checked, and moving a static Trigger has no
+		 * effect until the index is rebuilt.
+		 * @param is_static true to mark the Trigger as static.
+		 */
+		void setStatic(bool is_static);
+
+		/**
+		 * Sets the layers the Trigger belongs to, by default only the first one.
+		 * @param category one bit per layer.
+		 */
+		void setCategory(std::uint32_t category);
+
+		/**
+		 * Sets the layers the Trigger can be superposed with, by default all of them.
+		 * @param collision_mask one bit per layer.
+		 */
+		void setCollisionMask(std::uint32_t collision_mask);
+
+		/**
+		 * Removes the Trigger from its world making it so fireTrigger is never executed. O(log n) on the amount of
+		 * active Triggers, O(1) for static Triggers.
 		 */
 		void unsubscribe();
 
 		/**
-		 * Adds the trigger to the active triggers list making it so fireTrigger is executed when in superposition with
-		 * another Trigger.
+		 * Adds the trigger to the world of the Room that holds it, making it so fireTrigger is executed when in
+		 * superposition with another Trigger of the same Room. O(log n) on the amount of active Triggers, O(1) for
+		 * static Triggers. A Trigger moved to another Room must subscribe again to join its world.
 		 */
 		void subscribe();
 
@@ -127,9 +512,51 @@ namespace mate {
 		void loop() override;
 
 		/**
-		 * On renderLoop Triggers clear their checked flag for the next frame.
+		 * Ends the tick of a world whose hierarchy doesn't end on a Room, the first Trigger to run it fires the onExit
+		 * events of the tick. The Rooms end the ticks of their worlds themselves, see endTick().
 		 */
 		void renderLoop() override;
+
+		/**
+		 * Closes the contacts frame of the tick, firing its onExit events, so every Trigger is checked again on the
+		 * next one. Called by the Room at the end of every loop(), even if none of its Triggers is left, so the
+		 * contacts of destroyed Triggers always end.
+		 */
+		static void endTick(trigger_world &world);
+
+		// Spatial queries, used by the Room ones
+
+		/**
+		 * Finds the active Triggers of a world superposed with a shape.
+		 * @param result cleared and filled with the Triggers found, sorted by subscription order.
+		 * @return amount of Triggers found.
+		 */
+		static std::size_t queryShape(trigger_world &world, ShapeType shape, sf::Vector2f position,
+		                              sf::Vector2f dimensions, std::vector<std::shared_ptr<Trigger>> &result,
+		                              std::uint32_t mask);
+
+		/**
+		 * Finds the active Triggers of a world containing a point.
+		 * @param result cleared and filled with the Triggers found, sorted by subscription order.
+		 * @return amount of Triggers found.
+		 */
+		static std::size_t queryPoint(trigger_world &world, sf::Vector2f point,
+		                              std::vector<std::shared_ptr<Trigger>> &result, std::uint32_t mask);
+
+		/**
+		 * Finds the active Triggers of a world hit by a ray.
+		 * @param first_only if true only the closest hit is kept and the ray is shortened on every hit.
+		 * @param hits cleared and filled with the hits sorted by distance and then by subscription order.
+		 * @return amount of hits.
+		 */
+		static std::size_t raycast(trigger_world &world, sf::Vector2f origin, sf::Vector2f direction,
+		                           float max_distance, bool first_only, std::vector<raycast_hit> &hits,
+		                           std::uint32_t mask);
+
+		/**
+		 * @return Trigger subscribed with handle, empty if it unsubscribed or no longer exists. O(1).
+		 */
+		static std::shared_ptr<Trigger> findTrigger(const trigger_world &world, trigger_handle handle);
 	};
 
 	class EmptyTrigger : public Trigger
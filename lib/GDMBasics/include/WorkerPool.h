@@ -0,0 +1,76 @@
+/**
+ * @brief WorkerPool class declaration.
+ * @file
+ */
+
+#ifndef GDMATE_WORKERPOOL_H
+#define GDMATE_WORKERPOOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mate
+{
+/**
+ * @brief Set of persistent threads that run the same task together with the calling thread.
+ *
+ * The threads are created once and sleep between tasks, so running a task every frame doesn't pay for creating
+ * threads. Work is split by the task itself, usually with an atomic counter shared by all the participants.
+ */
+class WorkerPool
+{
+  public:
+    /**
+     * @param participants threads running every task, including the calling one.
+     */
+    explicit WorkerPool(unsigned int participants = 1);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /**
+     * Changes the amount of threads, waits for the current ones to finish.
+     * @param participants threads running every task, including the calling one. 0 uses one per hardware thread.
+     */
+    void resize(unsigned int participants);
+
+    /**
+     * @return threads running every task, including the calling one.
+     */
+    [[nodiscard]] unsigned int size() const
+    {
+        return static_cast<unsigned int>(_threads.size()) + 1;
+    }
+
+    /**
+     * Calls task(participant) once on every thread, participant 0 being the calling thread, and waits until all of
+     * them return. The task must not throw.
+     */
+    void run(const std::function<void(unsigned int)> &task);
+
+  private:
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _start;
+    std::condition_variable _done;
+    const std::function<void(unsigned int)> *_task = nullptr;
+    unsigned long _generation = 0; ///< Increased on every run, wakes the threads.
+    unsigned int _pending = 0;     ///< Threads that didn't finish the current task.
+    bool _stop = false;
+
+    /**
+     * Thread loop, runs every task started after generation.
+     */
+    void work(unsigned int participant, unsigned long generation);
+    /**
+     * Wakes and joins all the threads.
+     */
+    void stop();
+};
+} // namespace mate
+
+#endif // GDMATE_WORKERPOOL_H
@@ -11,7 +11,6 @@ Camera::Camera(const std::weak_ptr<Element> &parent) : Component(parent)
 {
     _view.setCenter(sf::Vector2f(0, 0));
     _view.setSize(sf::Vector2f(480, 360));
-    _game_manager = mate::Game::getGame();
     _aspect_ratio = 4.0f / 3.0f;
 }
 
@@ -23,6 +22,24 @@ Camera::~Camera()
     }
 }
 
+std::shared_ptr<Game> Camera::findGame()
+{
+    if (auto game = _game_manager.lock())
+    {
+        return game;
+    }
+    LocalCoords *root = getParentCoords();
+    while (root && root->getParentCoords())
+    {
+        root = root->getParentCoords();
+    }
+    const auto *room = dynamic_cast<Room *>(root);
+    auto game = room ? room->getGame() : nullptr;
+    // Empty until the Room is added to a Game
+    _game_manager = game;
+    return game;
+}
+
 float Camera::getRatio()
 {
     auto size = _view.getSize();
@@ -32,7 +49,7 @@ float Camera::getRatio()
 
 unsigned int Camera::useNewTarget(const std::string &title)
 {
-    if (auto _spt_game = _game_manager.lock())
+    if (auto _spt_game = findGame())
     {
         target_id = _spt_game->addSecondaryTarget(_view, title);
     }
@@ -41,31 +58,39 @@ unsigned int Camera::useNewTarget(const std::string &title)
 
 void Camera::renderLoop()
 {
-    auto _spt_game = _game_manager.lock();
-    if (!_spt_game)
-    {
-        return;
-    }
+    auto _spt_game = findGame();
 
-    if (std::shared_ptr<LocalCoords> spt_parent = _parent.lock())
+    if (LocalCoords *parent = getParentCoords())
     {
-        _view.setCenter(spt_parent->getWorldPosition());
-        _view.setRotation(spt_parent->getWorldRotation());
+        _view.setCenter(parent->getWorldPosition());
+        _view.setRotation(parent->getWorldRotation());
     }
 
-    _visible_sprites.remove_if([](const std::weak_ptr<const Sprite> &sprite) { return sprite.expired(); });
+    _visible_sprites.remove_if([](const visible_sprite &visible) { return !Component::fromHandle(visible.handle); });
 
-    _visible_sprites.sort([](const std::weak_ptr<const Sprite> &a, const std::weak_ptr<const Sprite> &b) {
-        auto spt_a = a.lock();
-        auto spt_b = b.lock();
-        int depth_a = spt_a->getElementDepth();
-        int depth_b = spt_b->getElementDepth();
-        return (depth_a < depth_b || (depth_a == depth_b && spt_a->getSprite()->depth < spt_b->getSprite()->depth));
+    _visible_sprites.sort([](const visible_sprite &a, const visible_sprite &b) {
+        const auto *sprite_a = static_cast<const Sprite *>(Component::fromHandle(a.handle));
+        const auto *sprite_b = static_cast<const Sprite *>(Component::fromHandle(b.handle));
+        int depth_a = sprite_a->getElementDepth();
+        int depth_b = sprite_b->getElementDepth();
+        return (depth_a < depth_b ||
+                (depth_a == depth_b && sprite_a->getSprite()->depth < sprite_b->getSprite()->depth));
     });
 
-    for (const auto &sprite : _visible_sprites)
+    if (!_spt_game)
     {
-        _spt_game->draw(sprite.lock()->getSprite(), target_id);
+        // Nothing to draw on until the Room is added to a Game
+        return;
+    }
+
+    for (const auto &visible : _visible_sprites)
+    {
+        const auto *sprite = static_cast<const Sprite *>(Component::fromHandle(visible.handle));
+        // Sprites of pooled Elements waiting to be spawned again
+        if (!sprite->isSleeping())
+        {
+            _spt_game->draw(sprite->getSprite(), target_id);
+        }
     }
 
     _spt_game->setWindowView(_view, target_id);
@@ -73,7 +98,7 @@ void Camera::renderLoop()
 
 void Camera::windowResizeEvent()
 {
-    auto _spt_game = _game_manager.lock();
+    auto _spt_game = findGame();
     if (!_spt_game)
     {
         return;
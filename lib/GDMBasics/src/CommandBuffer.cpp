@@ -0,0 +1,88 @@
+/**
+ * @brief CommandBuffer class methods definitions
+ * @file CommandBuffer.cpp
+ */
+
+#include "Basics.h"
+
+namespace mate
+{
+void CommandBuffer::addElement(element_hook setup)
+{
+    record([setup = std::move(setup)](Room &room) {
+        auto element = room.addElement();
+        if (setup)
+        {
+            setup(element);
+        }
+    });
+}
+
+void CommandBuffer::addChild(const std::weak_ptr<Element> &parent, element_hook setup)
+{
+    record([parent, setup = std::move(setup)](Room &) {
+        if (const auto spt_parent = parent.lock(); spt_parent && !spt_parent->shouldDestroy())
+        {
+            auto child = spt_parent->addChild();
+            if (setup)
+            {
+                setup(child);
+            }
+        }
+    });
+}
+
+void CommandBuffer::setParent(const std::weak_ptr<LocalCoords> &coords, const std::weak_ptr<LocalCoords> &parent)
+{
+    record([coords, parent](Room &) {
+        if (const auto spt_coords = coords.lock())
+        {
+            spt_coords->setParent(parent);
+        }
+    });
+}
+
+void CommandBuffer::destroy(const std::weak_ptr<IDestroy> &object)
+{
+    record([object](Room &) {
+        if (const auto spt_object = object.lock())
+        {
+            spt_object->destroy();
+        }
+    });
+}
+
+void CommandBuffer::purge(const std::weak_ptr<Element> &element)
+{
+    record([element](Room &) {
+        if (const auto spt_element = element.lock())
+        {
+            spt_element->purge();
+        }
+    });
+}
+
+std::size_t CommandBuffer::apply(Room &room)
+{
+    std::size_t applied = 0;
+    std::vector<std::function<void(Room &)>> commands;
+    while (true)
+    {
+        {
+            std::lock_guard lock(_mutex);
+            if (_commands.empty())
+            {
+                return applied;
+            }
+            commands.swap(_commands);
+        }
+        // Unlocked, the commands may record new ones
+        for (auto &command : commands)
+        {
+            command(room);
+        }
+        applied += commands.size();
+        commands.clear();
+    }
+}
+} // namespace mate
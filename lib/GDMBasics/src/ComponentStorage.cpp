@@ -0,0 +1,16 @@
+/**
+ * @brief ComponentStorage related function definitions
+ * @file ComponentStorage.cpp
+ */
+
+#include "ComponentStorage.h"
+#include <atomic>
+
+namespace mate
+{
+std::size_t nextComponentTypeId()
+{
+    static std::atomic<std::size_t> next_id = 0;
+    return next_id++;
+}
+} // namespace mate
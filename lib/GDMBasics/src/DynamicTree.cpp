@@ -0,0 +1,276 @@
+/**
+ * @brief DynamicTree class methods definitions
+ * @file DynamicTree.cpp
+ */
+
+#include "DynamicTree.h"
+#include <algorithm>
+
+namespace mate
+{
+namespace
+{
+sf::FloatRect combine(const sf::FloatRect &a, const sf::FloatRect &b)
+{
+    const float left = std::min(a.left, b.left);
+    const float top = std::min(a.top, b.top);
+    const float right = std::max(a.left + a.width, b.left + b.width);
+    const float bottom = std::max(a.top + a.height, b.top + b.height);
+    return {left, top, right - left, bottom - top};
+}
+
+/**
+ * Perimeter is used as the 2D equivalent of the surface area heuristic.
+ */
+float perimeter(const sf::FloatRect &rect)
+{
+    return 2 * (rect.width + rect.height);
+}
+
+bool contains(const sf::FloatRect &outer, const sf::FloatRect &inner)
+{
+    return outer.left <= inner.left && outer.top <= inner.top &&
+           inner.left + inner.width <= outer.left + outer.width && inner.top + inner.height <= outer.top + outer.height;
+}
+} // namespace
+
+DynamicTree::DynamicTree(float margin) : _margin(margin > 0 ? margin : 0)
+{
+}
+
+int DynamicTree::allocateNode()
+{
+    if (_free_list == null_node)
+    {
+        _nodes.emplace_back();
+        return static_cast<int>(_nodes.size()) - 1;
+    }
+    const int index = _free_list;
+    _free_list = _nodes[index].parent;
+    _nodes[index] = node{};
+    return index;
+}
+
+void DynamicTree::freeNode(int index)
+{
+    _nodes[index].parent = _free_list;
+    _nodes[index].height = -1;
+    _free_list = index;
+}
+
+int DynamicTree::createProxy(const sf::FloatRect &bounds)
+{
+    const int proxy = allocateNode();
+    _nodes[proxy].bounds = {bounds.left - _margin, bounds.top - _margin, bounds.width + 2 * _margin,
+                            bounds.height + 2 * _margin};
+    _nodes[proxy].height = 0;
+    insertLeaf(proxy);
+    ++_proxy_count;
+    return proxy;
+}
+
+void DynamicTree::destroyProxy(int proxy)
+{
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --_proxy_count;
+}
+
+bool DynamicTree::moveProxy(int proxy, const sf::FloatRect &bounds)
+{
+    if (contains(_nodes[proxy].bounds, bounds))
+    {
+        return false;
+    }
+    removeLeaf(proxy);
+    _nodes[proxy].bounds = {bounds.left - _margin, bounds.top - _margin, bounds.width + 2 * _margin,
+                            bounds.height + 2 * _margin};
+    insertLeaf(proxy);
+    return true;
+}
+
+void DynamicTree::insertLeaf(int leaf)
+{
+    if (_root == null_node)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = null_node;
+        return;
+    }
+
+    // Finds the best sibling, descending while that's cheaper than pairing with the current node
+    const sf::FloatRect leaf_bounds = _nodes[leaf].bounds;
+    int index = _root;
+    while (!_nodes[index].isLeaf())
+    {
+        const node &current = _nodes[index];
+        const float area = perimeter(current.bounds);
+        const float combined_area = perimeter(combine(current.bounds, leaf_bounds));
+
+        // Cost of making a new parent for this node and the leaf
+        const float cost = 2 * combined_area;
+        // Minimum cost of pushing the leaf further down the tree
+        const float inheritance_cost = 2 * (combined_area - area);
+
+        auto descend_cost = [&](int child) {
+            const float child_combined = perimeter(combine(leaf_bounds, _nodes[child].bounds));
+            if (_nodes[child].isLeaf())
+            {
+                return child_combined + inheritance_cost;
+            }
+            return child_combined - perimeter(_nodes[child].bounds) + inheritance_cost;
+        };
+        const float cost_a = descend_cost(current.child_a);
+        const float cost_b = descend_cost(current.child_b);
+
+        if (cost < cost_a && cost < cost_b)
+        {
+            break;
+        }
+        index = cost_a < cost_b ? current.child_a : current.child_b;
+    }
+
+    const int sibling = index;
+    const int old_parent = _nodes[sibling].parent;
+    const int new_parent = allocateNode();
+    _nodes[new_parent].parent = old_parent;
+    _nodes[new_parent].bounds = combine(leaf_bounds, _nodes[sibling].bounds);
+    _nodes[new_parent].height = _nodes[sibling].height + 1;
+    _nodes[new_parent].child_a = sibling;
+    _nodes[new_parent].child_b = leaf;
+    _nodes[sibling].parent = new_parent;
+    _nodes[leaf].parent = new_parent;
+
+    if (old_parent == null_node)
+    {
+        _root = new_parent;
+    }
+    else if (_nodes[old_parent].child_a == sibling)
+    {
+        _nodes[old_parent].child_a = new_parent;
+    }
+    else
+    {
+        _nodes[old_parent].child_b = new_parent;
+    }
+
+    fixUpwards(_nodes[leaf].parent);
+}
+
+void DynamicTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = null_node;
+        return;
+    }
+
+    const int parent = _nodes[leaf].parent;
+    const int grand_parent = _nodes[parent].parent;
+    const int sibling = _nodes[parent].child_a == leaf ? _nodes[parent].child_b : _nodes[parent].child_a;
+
+    // The sibling takes the place of the parent
+    _nodes[sibling].parent = grand_parent;
+    freeNode(parent);
+    if (grand_parent == null_node)
+    {
+        _root = sibling;
+        return;
+    }
+    if (_nodes[grand_parent].child_a == parent)
+    {
+        _nodes[grand_parent].child_a = sibling;
+    }
+    else
+    {
+        _nodes[grand_parent].child_b = sibling;
+    }
+    fixUpwards(grand_parent);
+}
+
+void DynamicTree::fixUpwards(int index)
+{
+    while (index != null_node)
+    {
+        index = balance(index);
+        node &current = _nodes[index];
+        current.height = 1 + std::max(_nodes[current.child_a].height, _nodes[current.child_b].height);
+        current.bounds = combine(_nodes[current.child_a].bounds, _nodes[current.child_b].bounds);
+        index = current.parent;
+    }
+}
+
+int DynamicTree::balance(int index_a)
+{
+    node &a = _nodes[index_a];
+    if (a.isLeaf() || a.height < 2)
+    {
+        return index_a;
+    }
+
+    const int index_b = a.child_a;
+    const int index_c = a.child_b;
+    node &b = _nodes[index_b];
+    node &c = _nodes[index_c];
+    const int difference = c.height - b.height;
+
+    // Rotates the taller child up, the shorter grandchild goes down to a
+    auto rotate = [&](int index_up, node &up, node &other, bool up_is_child_b) {
+        const int index_f = up.child_a;
+        const int index_g = up.child_b;
+        node &f = _nodes[index_f];
+        node &g = _nodes[index_g];
+
+        up.child_a = index_a;
+        up.parent = a.parent;
+        a.parent = index_up;
+
+        if (up.parent == null_node)
+        {
+            _root = index_up;
+        }
+        else if (_nodes[up.parent].child_a == index_a)
+        {
+            _nodes[up.parent].child_a = index_up;
+        }
+        else
+        {
+            _nodes[up.parent].child_b = index_up;
+        }
+
+        const bool keep_f = f.height > g.height;
+        const int index_kept = keep_f ? index_f : index_g;
+        const int index_moved = keep_f ? index_g : index_f;
+        node &kept = keep_f ? f : g;
+        node &moved = keep_f ? g : f;
+
+        up.child_b = index_kept;
+        if (up_is_child_b)
+        {
+            a.child_b = index_moved;
+        }
+        else
+        {
+            a.child_a = index_moved;
+        }
+        moved.parent = index_a;
+
+        a.bounds = combine(other.bounds, moved.bounds);
+        up.bounds = combine(a.bounds, kept.bounds);
+        a.height = 1 + std::max(other.height, moved.height);
+        up.height = 1 + std::max(a.height, kept.height);
+    };
+
+    if (difference > 1)
+    {
+        rotate(index_c, c, b, true);
+        return index_c;
+    }
+    if (difference < -1)
+    {
+        rotate(index_b, b, c, false);
+        return index_b;
+    }
+    return index_a;
+}
+} // namespace mate
@@ -3,19 +3,168 @@
 //
 
 #include "Basics.h"
+#include "JobSystem.h"
 
 namespace mate
 {
 std::shared_ptr<Element> Element::addChild()
 {
-    auto child = std::make_shared<Element>(shared_from_this(), getPosition());
+    auto child = std::allocate_shared<Element>(ArenaAllocator<Element>(_arena), shared_from_this(), getPosition());
+    child->useArena(_arena);
+    child->_owner_handle = getHandle();
     _children.push_back(child);
+    _render_loops.push_back(child.get());
+    _resize_loops.push_back(child.get());
+    ++_elements_count;
+    changeSubtreeCounts(1, 0);
     return std::move(child);
 }
 
+void Element::useArena(const std::shared_ptr<RoomArena> &arena)
+{
+    _arena = arena;
+    const ArenaAllocator<std::shared_ptr<ILowLoop>> allocator(arena);
+    _children = low_loop_list(std::make_move_iterator(_children.begin()), std::make_move_iterator(_children.end()),
+                              allocator);
+    _stored_components = low_loop_list(std::make_move_iterator(_stored_components.begin()),
+                                       std::make_move_iterator(_stored_components.end()), allocator);
+}
+
+void Element::sleep()
+{
+    for (const auto &components : _components_by_type)
+    {
+        for (const auto &component : components)
+        {
+            component->setSleeping(true);
+        }
+    }
+    for (const auto &child : _children)
+    {
+        if (const auto element = std::dynamic_pointer_cast<Element>(child))
+        {
+            element->sleep();
+        }
+    }
+}
+
+void Element::wake()
+{
+    _destroy_flag = false;
+    for (const auto &components : _components_by_type)
+    {
+        for (const auto &component : components)
+        {
+            component->setSleeping(false);
+        }
+    }
+    for (const auto &child : _children)
+    {
+        if (const auto element = std::dynamic_pointer_cast<Element>(child))
+        {
+            element->wake();
+        }
+    }
+}
+
+void Element::changeSubtreeCounts(const long elements, const long main_thread_components)
+{
+    Element *element = this;
+    while (element)
+    {
+        element->_full_elements_count += elements;
+        element->_main_thread_count += main_thread_components;
+        // Only Elements are registered as owners
+        element = static_cast<Element *>(LocalCoords::fromHandle(element->_owner_handle));
+    }
+}
+
+void Element::releaseChild(const std::shared_ptr<ILowLoop> &child)
+{
+    if (JobSystem::insideJob())
+    {
+        // Destruction touches the arena and the handle tables, it's left to the thread running the Room
+        JobSystem::deferRelease(child);
+    }
+    // Only on structural changes, never on the lookups
+    if (const auto element = std::dynamic_pointer_cast<Element>(child))
+    {
+        --_elements_count;
+        changeSubtreeCounts(-1 - static_cast<long>(element->_full_elements_count),
+                            -static_cast<long>(element->_main_thread_count));
+        element->_owner_handle = {};
+    }
+}
+
+void Element::purgeComponentIndex()
+{
+    for (auto &components : _components_by_type)
+    {
+        _indexed_components -= std::erase_if(components, [](auto &component) { return component->shouldDestroy(); });
+    }
+}
+
+Room *Element::findRoom() const
+{
+    LocalCoords *root = getParentCoords();
+    if (!root)
+    {
+        return nullptr;
+    }
+    while (LocalCoords *parent = root->getParentCoords())
+    {
+        root = parent;
+    }
+    return dynamic_cast<Room *>(root);
+}
+
+ComponentStorage *Element::findComponentStorage() const
+{
+    const Room *room = findRoom();
+    return room ? room->getComponentStorage() : nullptr;
+}
+
+CommandBuffer *Element::getCommands() const
+{
+    Room *room = findRoom();
+    return room ? &room->getCommands() : nullptr;
+}
+
+void Element::setOwnerRoom(const Room &room)
+{
+    _owner_room_handle = room.getHandle();
+}
+
+void Component::destroy()
+{
+    _destroy_flag = true;
+    // Only on destruction, never on the loops
+    if (auto *element = dynamic_cast<Element *>(getParentCoords()))
+    {
+        element->requestPurge();
+    }
+}
+
 void Element::destroy()
 {
     _destroy_flag = true;
+    // Only the owner sweeps its lists
+    if (auto *owner = static_cast<Element *>(LocalCoords::fromHandle(_owner_handle)))
+    {
+        owner->requestPurge();
+    }
+    else if (auto *room = static_cast<Room *>(LocalCoords::fromHandle(_owner_room_handle)))
+    {
+        room->requestPurge();
+    }
+    if (isPooled())
+    {
+        return;
+    }
+    for (auto &component : _stored_components)
+    {
+        component->destroy();
+    }
     for (auto &child : _children)
     {
         if(auto element = std::dynamic_pointer_cast<Element>(child)){
@@ -39,64 +188,92 @@ void Element::loop()
         }
     }
 
-    if (_destroy_flag)
+    if (_destroy_flag && isPooled())
     {
-        _children.clear();
+        // Kept whole for its pool
+        return;
     }
-
-    _children.remove_if([](auto &child) { return child->shouldDestroy(); });
+    if (!_destroy_flag && !_purge_pending)
+    {
+        return;
+    }
+    if (JobSystem::insideJob())
+    {
+        if (CommandBuffer *commands = getCommands())
+        {
+            // The nodes of the lists live on the RoomArena, they're freed by the thread running the Room
+            commands->purge(std::static_pointer_cast<Element>(shared_from_this()));
+            return;
+        }
+    }
+    purge();
 }
 
-void Element::renderLoop()
+void Element::purge()
 {
-    for (auto &element : _children)
+    _purge_pending = false;
+
+    // Everything is removed once the Element is marked for destruction. The phase lists first, _children owns them
+    const auto unlisted = [this](const ILowLoop *child) { return _destroy_flag || child->shouldDestroy(); };
+    std::erase_if(_render_loops, unlisted);
+    std::erase_if(_resize_loops, unlisted);
+    std::erase_if(_move_listeners, unlisted);
+    if (const auto released = std::erase_if(_main_thread_loops, unlisted))
     {
-        element->renderLoop();
+        changeSubtreeCounts(0, -static_cast<long>(released));
     }
+    const auto removed = _children.remove_if([this](auto &child) {
+        if (_destroy_flag || child->shouldDestroy())
+        {
+            releaseChild(child);
+            return true;
+        }
+        return false;
+    });
+    const auto removed_stored = _stored_components.remove_if([this](auto &component) {
+        if (_destroy_flag || component->shouldDestroy())
+        {
+            if (JobSystem::insideJob())
+            {
+                JobSystem::deferRelease(component);
+            }
+            return true;
+        }
+        return false;
+    });
 
-    for (const auto &component : _children)
+    if (_destroy_flag)
     {
-        component->renderLoop();
+        _components_by_type.clear();
+        _indexed_components = 0;
     }
-}
-
-void Element::windowResizeEvent()
-{
-    for (auto &element : _children)
+    else if ((removed || removed_stored) && _indexed_components)
     {
-        element->windowResizeEvent();
+        purgeComponentIndex();
     }
+}
 
-    for (const auto &component : _children)
+void Element::onWorldInvalidated()
+{
+    for (Component *listener : _move_listeners)
     {
-        component->windowResizeEvent();
+        listener->onParentMoved();
     }
 }
 
-unsigned long Element::getElementsCount() const
+void Element::renderLoop()
 {
-    ulong count = 0;
-    for (const auto &child : _children)
+    for (ILowLoop *child : _render_loops)
     {
-        if (std::dynamic_pointer_cast<Element>(child))
-        {
-            ++count;
-        }
+        child->renderLoop();
     }
-    return count;
 }
 
-unsigned long Element::getFullElementsCount()
+void Element::windowResizeEvent()
 {
-    unsigned long count = 0;
-    for (const auto &child : _children)
+    for (ILowLoop *child : _resize_loops)
     {
-        if (auto element = std::dynamic_pointer_cast<Element>(child))
-        {
-            ++count;
-            count += element->getFullElementsCount();
-        }
+        child->windowResizeEvent();
     }
-    return count;
 }
 } // namespace mate
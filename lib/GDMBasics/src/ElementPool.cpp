@@ -0,0 +1,75 @@
+/**
+ * @brief ElementPool class methods definitions
+ * @file ElementPool.cpp
+ */
+
+#include "ElementPool.h"
+
+namespace mate
+{
+ElementPool::ElementPool(const std::shared_ptr<Room> &room, element_hook prefab, element_hook reset)
+    : _room(room), _prefab(std::move(prefab)), _reset(std::move(reset))
+{
+}
+
+std::shared_ptr<Element> ElementPool::build(const std::shared_ptr<Room> &room)
+{
+    // Same as Room::addElement(), the Room's loops get the Element on spawn()
+    auto element = std::allocate_shared<Element>(ArenaAllocator<Element>(room->getArena()),
+                                                 std::static_pointer_cast<LocalCoords>(room), room->getPosition());
+    element->useArena(room->getArena());
+    element->setPool(weak_from_this());
+    if (_prefab)
+    {
+        _prefab(element);
+    }
+    ++_built_count;
+    return element;
+}
+
+std::shared_ptr<Element> ElementPool::spawn()
+{
+    const auto room = _room.lock();
+    if (!room)
+    {
+        return nullptr;
+    }
+    if (_free_elements.empty())
+    {
+        auto element = build(room);
+        room->addElement(element);
+        return element;
+    }
+
+    auto element = std::move(_free_elements.back());
+    _free_elements.pop_back();
+    element->wake();
+    room->addElement(element);
+    if (_reset)
+    {
+        _reset(element);
+    }
+    return element;
+}
+
+void ElementPool::reserve(const std::size_t count)
+{
+    const auto room = _room.lock();
+    if (!room)
+    {
+        return;
+    }
+    while (_free_elements.size() < count)
+    {
+        auto element = build(room);
+        element->sleep();
+        _free_elements.push_back(std::move(element));
+    }
+}
+
+void ElementPool::release(const std::shared_ptr<Element> &element)
+{
+    element->sleep();
+    _free_elements.push_back(element);
+}
+} // namespace mate
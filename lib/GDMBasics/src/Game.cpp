@@ -3,103 +3,153 @@
 //
 
 #include "Basics.h"
+#include <utility>
 
 namespace mate
 {
 std::shared_ptr<Game> Game::_instance = nullptr;
+std::mutex Game::_instance_mutex;
 
-void Game::setWindowView(sf::View view_, u_int id_) const
+render_target Game::makeTarget(const GameMode mode_, const u_int id_, const sf::View &view_,
+                               const std::string &title)
+{
+    render_target new_target(id_);
+    if (mode_ == HEADLESS)
+    {
+        new_target.headless = std::make_unique<null_window>();
+        new_target.headless->size = sf::Vector2u(800, 400);
+        new_target.headless->view = view_;
+        return new_target;
+    }
+    new_target.target = std::make_unique<sf::RenderWindow>(sf::VideoMode(800, 400), title);
+    new_target.target->setView(view_);
+    return new_target;
+}
+
+const render_target *Game::findTarget(u_int id_) const
 {
     if (id_ == 0)
     {
-        _main_render_target.target->setView(view_);
-        return;
+        return &_main_render_target;
     }
     for (const auto &target : _secondary_targets)
     {
         if (target.id == id_)
         {
-            target.target->setView(view_);
-            return;
+            return &target;
         }
     }
+    return nullptr;
 }
 
-sf::Vector2i Game::getWindowPosition(uint id_) const
+render_target *Game::findTarget(u_int id_)
 {
-    if (id_ == 0)
+    return const_cast<render_target *>(std::as_const(*this).findTarget(id_));
+}
+
+void Game::setWindowView(sf::View view_, u_int id_) const
+{
+    const render_target *target = findTarget(id_);
+    if (!target)
     {
-        return _main_render_target.target->getPosition();
+        return;
     }
-    for (const auto &target : _secondary_targets)
+    if (target->target)
     {
-        if (target.id == id_)
-        {
-            return target.target->getPosition();
-        }
+        target->target->setView(view_);
+        return;
     }
-    return {0, 0};
+    target->headless->view = view_;
 }
 
-void Game::setWindowPosition(int x, int y, uint id_) const
+void Game::setWindowView() const
 {
-    if (id_ == 0)
+    if (_main_render_target.target)
     {
-        _main_render_target.target->setPosition(sf::Vector2i(x, y));
+        _main_render_target.target->setView(_main_render_target.target->getDefaultView());
         return;
     }
-    for (const auto &target : _secondary_targets)
+    const sf::Vector2u size = _main_render_target.headless->size;
+    _main_render_target.headless->view = sf::View(sf::FloatRect(0, 0, (float)size.x, (float)size.y));
+}
+
+sf::Vector2i Game::getWindowPosition(uint id_) const
+{
+    const render_target *target = findTarget(id_);
+    if (!target)
     {
-        if (target.id == id_)
-        {
-            target.target->setPosition(sf::Vector2i(x, y));
-            return;
-        }
+        return {0, 0};
     }
+    return target->target ? target->target->getPosition() : target->headless->position;
 }
 
-sf::Vector2u Game::getWindowSize(uint id_) const
+void Game::setWindowPosition(int x, int y, uint id_) const
 {
-    if (id_ == 0)
+    const render_target *target = findTarget(id_);
+    if (!target)
     {
-        return _main_render_target.target->getSize();
+        return;
     }
-    for (const auto &target : _secondary_targets)
+    if (target->target)
     {
-        if (target.id == id_)
-        {
-            return target.target->getSize();
-        }
+        target->target->setPosition(sf::Vector2i(x, y));
+        return;
+    }
+    target->headless->position = sf::Vector2i(x, y);
+}
+
+sf::Vector2u Game::getWindowSize(uint id_) const
+{
+    const render_target *target = findTarget(id_);
+    if (!target)
+    {
+        return {0, 0};
     }
-    return {0, 0};
+    return target->target ? target->target->getSize() : target->headless->size;
 }
 
 void Game::setWindowSize(int x, int y, uint id_) const
 {
-    if (id_ == 0)
+    const render_target *target = findTarget(id_);
+    if (!target)
     {
-        _main_render_target.target->setSize(sf::Vector2u(x, y));
         return;
     }
-    for (const auto &target : _secondary_targets)
+    if (target->target)
     {
-        if (target.id == id_)
-        {
-            target.target->setSize(sf::Vector2u(x, y));
-            return;
-        }
+        target->target->setSize(sf::Vector2u(x, y));
+        return;
     }
+    target->headless->size = sf::Vector2u(x, y);
 }
 
 std::shared_ptr<Game> Game::getGame()
 {
-    // std::lock_guard<std::mutex> lock(mutex); //Uncomment when I start working with threads, maybe
+    std::lock_guard lock(_instance_mutex);
 
     if (!_instance)
     {
         _instance = std::shared_ptr<Game>(new Game());
         // Todo: set default values for screen size and game name
-        _instance->addRoom(std::move(std::make_shared<Room>()));
+        _instance->addRoom(std::make_shared<Room>());
+    }
+    return _instance;
+}
+
+std::shared_ptr<Game> Game::create(const GameMode mode_)
+{
+    auto game = std::shared_ptr<Game>(new Game(mode_));
+    game->addRoom(std::make_shared<Room>());
+    game->switchRoom(0);
+    return game;
+}
+
+std::shared_ptr<Game> Game::getGame(const GameMode mode_)
+{
+    std::lock_guard lock(_instance_mutex);
+    if (!_instance)
+    {
+        _instance = create(mode_);
     }
     return _instance;
 }
@@ -107,14 +157,17 @@ std::shared_ptr<Game> Game::getGame()
 std::shared_ptr<Game> Game::getGame(int win_width_, int win_height_, const std::string &game_name_,
                                     std::shared_ptr<Room> main_room_)
 {
-    // std::lock_guard<std::mutex> lock(mutex); //Uncomment when I start working with threads, maybe
+    std::lock_guard lock(_instance_mutex);
     if (!_instance)
     {
         _instance = std::shared_ptr<Game>(new Game());
     }
-    _instance->_main_render_target.target->setSize(sf::Vector2u(win_width_, win_height_));
-    _instance->_main_render_target.target->setTitle(game_name_);
-    _instance->_rooms.push_back(main_room_);
+    _instance->setWindowSize(win_width_, win_height_);
+    if (_instance->_main_render_target.target)
+    {
+        _instance->_main_render_target.target->setTitle(game_name_);
+    }
+    _instance->addRoom(main_room_);
     _instance->_active_room = std::move(main_room_);
     return _instance;
 }
@@ -122,13 +175,20 @@ std::shared_ptr<Game> Game::getGame(int win_width_, int win_height_, const std::
 [[maybe_unused]] std::shared_ptr<Game> Game::getGame(int win_width_, int win_height_, const std::string &game_name_,
                                                      std::list<std::shared_ptr<Room>> &rooms_list_)
 {
-    // std::lock_guard<std::mutex> lock(mutex); //Uncomment when I start working with threads, maybe
+    std::lock_guard lock(_instance_mutex);
     if (!_instance)
     {
         _instance = std::shared_ptr<Game>(new Game());
     }
-    _instance->_main_render_target.target->setSize(sf::Vector2u(win_width_, win_height_));
-    _instance->_main_render_target.target->setTitle(game_name_);
+    _instance->setWindowSize(win_width_, win_height_);
+    if (_instance->_main_render_target.target)
+    {
+        _instance->_main_render_target.target->setTitle(game_name_);
+    }
+    for (const auto &room : rooms_list_)
+    {
+        room->setGame(_instance);
+    }
     _instance->_rooms.merge(rooms_list_);
     if (!rooms_list_.empty())
     {
@@ -141,25 +201,29 @@ void Game::draw(const std::shared_ptr<const ord_sprite> &sprite_, u_int id_)
 {
     if (id_ == 0)
     {
-        _main_render_target.target->draw(sprite_->sprite);
+        if (_main_render_target.target)
+        {
+            _main_render_target.target->draw(sprite_->sprite);
+        }
+        ++_main_render_target.draw_calls;
     }
     else
     {
-        for (const auto &target : _secondary_targets)
+        for (auto &target : _secondary_targets)
         {
-            target.target->draw(sprite_->sprite);
+            if (target.target)
+            {
+                target.target->draw(sprite_->sprite);
+            }
+            ++target.draw_calls;
         }
     }
 }
 
 u_int Game::addSecondaryTarget(sf::View view_, const std::string &title)
 {
-    render_target new_target;
-    u_int id = new_target.id;
-    new_target.target = std::make_unique<sf::RenderWindow>(sf::VideoMode(800, 400), title);
-    new_target.target->setView(view_);
-    _secondary_targets.push_back(std::move(new_target));
-    return id;
+    _secondary_targets.push_back(makeTarget(_mode, _next_target_id++, view_, title));
+    return _secondary_targets.back().id;
 }
 
 [[maybe_unused]] void Game::switchRoom(int position_)
@@ -174,16 +238,56 @@ u_int Game::addSecondaryTarget(sf::View view_, const std::string &title)
 
 [[noreturn]] void Game::gameLoop()
 {
-    _main_render_target.target->setFramerateLimit(60);
+    setFramerateLimit(_framerate_limit);
+    _frame_clock.restart();
     do
     {
         runSingleFrame();
-    } while (_main_render_target.target->isOpen());
+    } while (!_main_render_target.target || _main_render_target.target->isOpen());
     exit(0);
 }
 
+unsigned int Game::simulate(const sf::Time elapsed)
+{
+    if (_fixed_step == sf::Time::Zero)
+    {
+        _active_room->setDeltaTime(elapsed);
+        _active_room->loop();
+        return 1;
+    }
+
+    _accumulator += elapsed;
+    unsigned int ticks = 0;
+    while (_accumulator >= _fixed_step && ticks < _max_ticks_per_frame)
+    {
+        _active_room->setDeltaTime(_fixed_step);
+        _active_room->loop();
+        _accumulator -= _fixed_step;
+        ++ticks;
+    }
+    if (_accumulator >= _fixed_step)
+    {
+        // Spiral of death, the time that didn't fit is dropped
+        _accumulator = sf::microseconds(_accumulator.asMicroseconds() % _fixed_step.asMicroseconds());
+    }
+    return ticks;
+}
+
 void Game::runSingleFrame()
 {
+    if (_mode == HEADLESS)
+    {
+        simulate(_fixed_step > sf::Time::Zero ? _fixed_step : sf::seconds(1.f / 60));
+        _main_render_target.draw_calls = 0;
+        for (auto &target : _secondary_targets)
+        {
+            target.draw_calls = 0;
+        }
+        _active_room->setInterpolation(getInterpolation());
+        _active_room->renderLoop();
+        return;
+    }
+
     // Event Pooling
     sf::Event event{};
     while (_main_render_target.target->pollEvent(event))
@@ -219,16 +323,18 @@ void Game::runSingleFrame()
 
     // Second targets windows events
 
-    // Todo: Data loop
-    _active_room->loop();
+    simulate(_frame_clock.restart());
 
     // Todo: Render Loop
     _main_render_target.target->clear();
-    for (const auto &target : _secondary_targets)
+    _main_render_target.draw_calls = 0;
+    for (auto &target : _secondary_targets)
     {
         target.target->clear();
+        target.draw_calls = 0;
     }
 
+    _active_room->setInterpolation(getInterpolation());
     _active_room->renderLoop();
 
     for (const auto &target : _secondary_targets)
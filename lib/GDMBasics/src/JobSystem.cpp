@@ -0,0 +1,167 @@
+/**
+ * @brief JobSystem class methods definitions
+ * @file JobSystem.cpp
+ */
+
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace mate
+{
+thread_local JobSystem *JobSystem::current_system = nullptr;
+thread_local unsigned int JobSystem::current_participant = 0;
+
+JobSystem::JobSystem(const unsigned int threads) : _pool(threads)
+{
+    resize(threads);
+}
+
+void JobSystem::resize(const unsigned int threads)
+{
+    _pool.resize(threads);
+    _queues.resize(_pool.size());
+    for (auto &queue : _queues)
+    {
+        if (!queue)
+        {
+            queue = std::make_unique<job_queue>();
+        }
+    }
+}
+
+void JobSystem::push(const unsigned int participant, job new_job)
+{
+    job_queue &queue = *_queues[participant];
+    std::lock_guard lock(queue.mutex);
+    queue.jobs.push_back(std::move(new_job));
+}
+
+bool JobSystem::runOne(const unsigned int participant)
+{
+    job current;
+    {
+        job_queue &own = *_queues[participant];
+        std::lock_guard lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            current = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+    // Steals the oldest job, usually the biggest one left
+    for (std::size_t offset = 1; !current && offset < _queues.size(); ++offset)
+    {
+        job_queue &victim = *_queues[(participant + offset) % _queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            current = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+    if (!current)
+    {
+        return false;
+    }
+    current();
+    --_pending;
+    return true;
+}
+
+void JobSystem::helpUntil(const unsigned int participant, const std::function<bool()> &done)
+{
+    while (!done())
+    {
+        if (!runOne(participant))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::run(std::vector<job> jobs)
+{
+    if (jobs.empty())
+    {
+        return;
+    }
+    _pending = jobs.size();
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        push(static_cast<unsigned int>(i % _queues.size()), std::move(jobs[i]));
+    }
+
+    _pool.run([this](const unsigned int participant) {
+        current_system = this;
+        current_participant = participant;
+        helpUntil(participant, [this]() { return _pending == 0; });
+        current_system = nullptr;
+    });
+
+    for (auto &queue : _queues)
+    {
+        queue->released.clear();
+    }
+}
+
+void JobSystem::spawn(job new_job)
+{
+    if (current_system != this)
+    {
+        new_job();
+        return;
+    }
+    ++_pending;
+    push(current_participant, std::move(new_job));
+}
+
+void JobSystem::parallelFor(const std::size_t count, const std::function<void(std::size_t)> &function)
+{
+    // A few chunks per thread leave room for stealing
+    const std::size_t chunks = std::min<std::size_t>(count, static_cast<std::size_t>(size()) * 4);
+    const auto chunk = [&function, count, chunks](const std::size_t index) {
+        for (std::size_t i = count * index / chunks; i < count * (index + 1) / chunks; ++i)
+        {
+            function(i);
+        }
+    };
+
+    if (chunks <= 1 || (insideJob() && current_system != this))
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            function(i);
+        }
+    }
+    else if (current_system == this)
+    {
+        std::atomic<std::size_t> remaining = chunks;
+        for (std::size_t index = 0; index < chunks; ++index)
+        {
+            spawn([&chunk, &remaining, index]() {
+                chunk(index);
+                --remaining;
+            });
+        }
+        helpUntil(current_participant, [&remaining]() { return remaining == 0; });
+    }
+    else
+    {
+        std::vector<job> jobs;
+        jobs.reserve(chunks);
+        for (std::size_t index = 0; index < chunks; ++index)
+        {
+            jobs.emplace_back([&chunk, index]() { chunk(index); });
+        }
+        run(std::move(jobs));
+    }
+}
+
+void JobSystem::deferRelease(std::shared_ptr<void> object)
+{
+    if (current_system)
+    {
+        current_system->_queues[current_participant]->released.push_back(std::move(object));
+    }
+}
+} // namespace mate
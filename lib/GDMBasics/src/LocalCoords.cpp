@@ -3,6 +3,9 @@
 //
 
 #include "LocalCoords.h"
+#include "TransformStore.h"
+#include "WorkerPool.h"
+#include <atomic>
 #include <memory>
 
 namespace mate
@@ -15,6 +18,7 @@ namespace mate
 [[maybe_unused]] LocalCoords::LocalCoords(const std::weak_ptr<LocalCoords> &parent) : _parent(parent)
 {
     setScale(1.0f, 1.0f);
+    attachToParent();
 }
 
 [[maybe_unused]] LocalCoords::LocalCoords(sf::Vector2f position, const std::shared_ptr<LocalCoords> &parent)
@@ -22,6 +26,7 @@ namespace mate
 {
     setPosition(position);
     setScale(1.0f, 1.0f);
+    attachToParent();
 }
 
 [[maybe_unused]] LocalCoords::LocalCoords(sf::Vector2f position, float rotation,
@@ -31,6 +36,7 @@ namespace mate
     setPosition(position);
     setScale(1.0f, 1.0f);
     setRotation(rotation);
+    attachToParent();
 }
 
 [[maybe_unused]] LocalCoords::LocalCoords(sf::Vector2f position, sf::Vector2f scale,
@@ -39,6 +45,7 @@ namespace mate
 {
     setPosition(position);
     setScale(scale);
+    attachToParent();
 }
 
 [[maybe_unused]] LocalCoords::LocalCoords(sf::Vector2f position, sf::Vector2f scale, float rotation,
@@ -48,32 +55,340 @@ namespace mate
     setPosition(position);
     setScale(scale);
     setRotation(rotation);
+    attachToParent();
 }
 
-sf::Vector2f LocalCoords::getWorldPosition()
+HandleTable<LocalCoords> &LocalCoords::handles()
 {
-    if (auto spt_parent = _parent.lock())
-        return spt_parent->getWorldPosition() + getPosition();
+    // Never destroyed, static objects like the Game may still hold objects when the program exits
+    static auto *table = new HandleTable<LocalCoords>();
+    return *table;
+}
+
+LocalCoords::~LocalCoords()
+{
+    detachFromParent();
+    // Orphaned children fall back to their local coordinates
+    for (LocalCoords *child : _children_coords)
+    {
+        child->_parent_handle = {};
+        if (child->_transform_store)
+        {
+            child->_transform_store->setParent(child->_transform_node, -1);
+        }
+        child->invalidateWorld();
+    }
+    if (_transform_store)
+    {
+        _transform_store->remove(_transform_node);
+    }
+    handles().remove(_handle);
+}
+
+void LocalCoords::setParent(const std::weak_ptr<LocalCoords> &parent)
+{
+    detachFromParent();
+    _parent = parent;
+    const auto spt_parent = parent.lock();
+    if (_transform_store && (!spt_parent || spt_parent->_transform_store == _transform_store))
+    {
+        _transform_store->setParent(_transform_node, spt_parent ? spt_parent->_transform_node : -1);
+    }
     else
-        return getPosition();
+    {
+        unbindStore();
+    }
+    // Joins the new parent's store if it has one
+    attachToParent();
+    invalidateWorld();
+}
+
+void LocalCoords::useTransformStore(const std::shared_ptr<TransformStore> &store)
+{
+    LocalCoords *root = this;
+    while (LocalCoords *parent = root->getParentCoords())
+    {
+        root = parent;
+    }
+    root->unbindStore();
+    if (store)
+    {
+        root->bindStore(store, -1);
+    }
+}
+
+void LocalCoords::bindStore(const std::shared_ptr<TransformStore> &store, const int parent_node)
+{
+    _transform_store = store;
+    _transform_node = store->add(parent_node);
+    store->setLocal(_transform_node, getTransform(), getScale(), getRotation());
+    for (LocalCoords *child : _children_coords)
+    {
+        child->bindStore(store, _transform_node);
+    }
+}
+
+void LocalCoords::unbindStore()
+{
+    if (!_transform_store)
+    {
+        return;
+    }
+    for (LocalCoords *child : _children_coords)
+    {
+        child->unbindStore();
+    }
+    _transform_store->remove(_transform_node);
+    _transform_store.reset();
+    _transform_node = -1;
+    // The cached values were not kept while on the store
+    _world_dirty = true;
+}
+
+void LocalCoords::localChanged()
+{
+    if (_transform_store)
+    {
+        _transform_store->setLocal(_transform_node, getTransform(), getScale(), getRotation());
+    }
+    // On a store the flags only track which objects were read since they changed
+    invalidateWorld();
+}
+
+void LocalCoords::attachToParent()
+{
+    if (const auto spt_parent = _parent.lock())
+    {
+        _parent_handle = spt_parent->_handle;
+        _child_index = spt_parent->_children_coords.size();
+        spt_parent->_children_coords.push_back(this);
+        if (!_transform_store && spt_parent->_transform_store)
+        {
+            bindStore(spt_parent->_transform_store, spt_parent->_transform_node);
+        }
+    }
+}
+
+void LocalCoords::detachFromParent()
+{
+    // The weak_ptr can't be used here, it's already expired while the parent destroys its children
+    if (LocalCoords *parent = getParentCoords())
+    {
+        auto &siblings = parent->_children_coords;
+        siblings[_child_index] = siblings.back();
+        siblings[_child_index]->_child_index = _child_index;
+        siblings.pop_back();
+    }
+    _parent_handle = {};
+}
+
+void LocalCoords::invalidateWorld()
+{
+    if (_world_dirty)
+    {
+        return;
+    }
+    _world_dirty = true;
+    onWorldInvalidated();
+    for (LocalCoords *child : _children_coords)
+    {
+        child->invalidateWorld();
+    }
+}
+
+void LocalCoords::markStoreRead() const
+{
+    // The ancestors were read by the store too, and clean objects never have dirty ancestors
+    for (const LocalCoords *object = this; object && object->_world_dirty; object = object->getParentCoords())
+    {
+        object->_world_dirty = false;
+    }
+}
+
+void LocalCoords::updateWorld() const
+{
+    if (!_world_dirty)
+    {
+        return;
+    }
+    _world_transform = getTransform();
+    _world_scale = getScale();
+    _world_rotation = getRotation();
+    if (const LocalCoords *parent = getParentCoords())
+    {
+        parent->updateWorld();
+        _world_transform = parent->_world_transform * _world_transform;
+        _world_scale.x *= parent->_world_scale.x;
+        _world_scale.y *= parent->_world_scale.y;
+        _world_rotation += parent->_world_rotation;
+    }
+    _world_dirty = false;
+}
+
+std::size_t LocalCoords::updateWorldTree(WorkerPool *pool)
+{
+    if (_transform_store)
+    {
+        _transform_store->update();
+        return _transform_store->size();
+    }
+
+    updateWorld();
+    if (!pool || pool->size() == 1 || _children_coords.size() < 2)
+    {
+        return 1 + updateDescendantsWorld();
+    }
+
+    // Every participant takes whole subtrees, one at a time
+    std::vector<std::size_t> counts(pool->size(), 0);
+    std::atomic<std::size_t> next_child = 0;
+    pool->run([&](const unsigned int participant) {
+        for (std::size_t child = next_child++; child < _children_coords.size(); child = next_child++)
+        {
+            _children_coords[child]->updateWorld();
+            counts[participant] += 1 + _children_coords[child]->updateDescendantsWorld();
+        }
+    });
+    std::size_t count = 1;
+    for (const std::size_t participant_count : counts)
+    {
+        count += participant_count;
+    }
+    return count;
+}
+
+std::size_t LocalCoords::updateDescendantsWorld() const
+{
+    std::size_t count = 0;
+    std::vector<const LocalCoords *> stack(_children_coords.begin(), _children_coords.end());
+    while (!stack.empty())
+    {
+        const LocalCoords *current = stack.back();
+        stack.pop_back();
+        // The parent is already up to date, so this doesn't walk up
+        current->updateWorld();
+        stack.insert(stack.end(), current->_children_coords.begin(), current->_children_coords.end());
+        ++count;
+    }
+    return count;
+}
+
+sf::Vector2f LocalCoords::getWorldPosition()
+{
+    if (_transform_store)
+    {
+        markStoreRead();
+        return _transform_store->getWorldPosition(_transform_node);
+    }
+    updateWorld();
+    // Translation column of the 4x4 matrix
+    const float *matrix = _world_transform.getMatrix();
+    return {matrix[12], matrix[13]};
 }
 
 sf::Vector2f LocalCoords::getWorldScale()
 {
-    sf::Vector2f newScale = getScale();
-    if (auto spt_parent = _parent.lock())
+    if (_transform_store)
     {
-        newScale.x *= spt_parent->getWorldScale().x;
-        newScale.y *= spt_parent->getWorldScale().y;
+        markStoreRead();
+        return _transform_store->getWorldScale(_transform_node);
     }
-    return newScale;
+    updateWorld();
+    return _world_scale;
 }
 
 float LocalCoords::getWorldRotation() const
 {
-    if (auto spt_parent = _parent.lock())
-        return spt_parent->getWorldRotation() + getRotation();
-    else
-        return getRotation();
+    if (_transform_store)
+    {
+        markStoreRead();
+        return _transform_store->getWorldRotation(_transform_node);
+    }
+    updateWorld();
+    return _world_rotation;
+}
+
+const sf::Transform &LocalCoords::getWorldTransform() const
+{
+    if (_transform_store)
+    {
+        _world_transform = _transform_store->getWorldTransform(_transform_node);
+        markStoreRead();
+        return _world_transform;
+    }
+    updateWorld();
+    return _world_transform;
+}
+
+void LocalCoords::setPosition(const float x, const float y)
+{
+    Transformable::setPosition(x, y);
+    localChanged();
+}
+
+void LocalCoords::setPosition(const sf::Vector2f &position)
+{
+    Transformable::setPosition(position);
+    localChanged();
+}
+
+void LocalCoords::setRotation(const float angle)
+{
+    Transformable::setRotation(angle);
+    localChanged();
+}
+
+void LocalCoords::setScale(const float factor_x, const float factor_y)
+{
+    Transformable::setScale(factor_x, factor_y);
+    localChanged();
+}
+
+void LocalCoords::setScale(const sf::Vector2f &factors)
+{
+    Transformable::setScale(factors);
+    localChanged();
+}
+
+void LocalCoords::setOrigin(const float x, const float y)
+{
+    Transformable::setOrigin(x, y);
+    localChanged();
+}
+
+void LocalCoords::setOrigin(const sf::Vector2f &origin)
+{
+    Transformable::setOrigin(origin);
+    localChanged();
+}
+
+void LocalCoords::move(const float offset_x, const float offset_y)
+{
+    Transformable::move(offset_x, offset_y);
+    localChanged();
+}
+
+void LocalCoords::move(const sf::Vector2f &offset)
+{
+    Transformable::move(offset);
+    localChanged();
+}
+
+void LocalCoords::rotate(const float angle)
+{
+    Transformable::rotate(angle);
+    localChanged();
+}
+
+void LocalCoords::scale(const float factor_x, const float factor_y)
+{
+    Transformable::scale(factor_x, factor_y);
+    localChanged();
+}
+
+void LocalCoords::scale(const sf::Vector2f &factor)
+{
+    Transformable::scale(factor);
+    localChanged();
 }
 } // namespace mate
@@ -0,0 +1,423 @@
+/**
+ * @brief Trigger shapes superposition tests definitions
+ * @file NarrowPhase.cpp
+ */
+
+#include "NarrowPhase.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace mate
+{
+// The scalar checks and the lanes versions below must perform the same operations in the same order, otherwise the
+// results of the batched checks would differ from the reference ones on the edges.
+
+bool rectangleToRectangleCheck(const sf::Vector2f rect1_pos, const sf::Vector2f rect1_dim, const sf::Vector2f rect2_pos,
+                               const sf::Vector2f rect2_dim)
+{
+    return rect1_pos.x + rect1_dim.x > rect2_pos.x && rect1_pos.x < rect2_pos.x + rect2_dim.x &&
+           rect1_pos.y < rect2_pos.y + rect2_dim.y && rect1_pos.y + rect1_dim.y > rect2_pos.y;
+}
+
+bool circleToCircleCheck(sf::Vector2f circ1_pos, const sf::Vector2f circ1_dim, sf::Vector2f circ2_pos,
+                         const sf::Vector2f circ2_dim)
+{
+    const float circ1_rad = std::max(circ1_dim.x, circ1_dim.y) / 2;
+    circ1_pos.x += circ1_rad;
+    circ1_pos.y += circ1_rad;
+
+    const float circ2_rad = std::max(circ2_dim.x, circ2_dim.y) / 2;
+    circ2_pos.x += circ2_rad;
+    circ2_pos.y += circ2_rad;
+
+    // Squared distances avoid the square root
+    const float distance_x = circ1_pos.x - circ2_pos.x;
+    const float distance_y = circ1_pos.y - circ2_pos.y;
+    const float radius_sum = circ1_rad + circ2_rad;
+    return radius_sum > 0 && distance_x * distance_x + distance_y * distance_y < radius_sum * radius_sum;
+}
+
+bool circleToRectangleCheck(sf::Vector2f circ_pos, const sf::Vector2f circ_dim, const sf::Vector2f rect_pos,
+                            const sf::Vector2f rect_dim)
+{
+    // Use the center of the circle instead of the corner, also stores the radius
+    const float radius = std::max(circ_dim.x, circ_dim.y) / 2;
+    circ_pos.x += radius;
+    circ_pos.y += radius;
+
+    const float half_width = rect_dim.x / 2;
+    const float half_height = rect_dim.y / 2;
+
+    // If distance_x is positive means circle is on the left, negative means it's on the right
+    float distance_x = rect_pos.x + half_width - circ_pos.x;
+    const bool left = distance_x >= 0;
+    // Checks if the circle is inside the rectangle using it's nearest horizontal sides
+    if ((left ? circ_pos.x + radius >= rect_pos.x : circ_pos.x - radius < rect_pos.x + rect_dim.x) &&
+        circ_pos.y <= rect_pos.y + rect_dim.y && circ_pos.y >= rect_pos.y)
+    {
+        return true;
+    }
+
+    // If distance_y is positive means circle is above, negative means it's below
+    // Same as before but using the vertical sides
+    float distance_y = rect_pos.y + half_height - circ_pos.y;
+    const bool above = distance_y >= 0;
+    if ((above ? circ_pos.y + radius >= rect_pos.y : circ_pos.y - radius < rect_pos.y + rect_dim.y) &&
+        circ_pos.x <= rect_pos.x + rect_dim.x && circ_pos.x >= rect_pos.x)
+    {
+        return true;
+    }
+
+    // Finally checks if the nearest corner of the rectangle is inside the circle
+    //  (Which can happen even when both the previous conditions are false)
+    distance_x = left ? distance_x - half_width : distance_x + half_width;
+    distance_y = above ? distance_y - half_height : distance_y + half_height;
+    return radius > 0 && distance_x * distance_x + distance_y * distance_y < radius * radius;
+}
+
+bool shapesCheck(const ShapeType shape_a, const sf::Vector2f pos_a, const sf::Vector2f dim_a, const ShapeType shape_b,
+                 const sf::Vector2f pos_b, const sf::Vector2f dim_b)
+{
+    if (shape_a == shape_b)
+    {
+        return shape_a == RECTANGLE ? rectangleToRectangleCheck(pos_a, dim_a, pos_b, dim_b)
+                                    : circleToCircleCheck(pos_a, dim_a, pos_b, dim_b);
+    }
+    return shape_a == CIRCLE ? circleToRectangleCheck(pos_a, dim_a, pos_b, dim_b)
+                             : circleToRectangleCheck(pos_b, dim_b, pos_a, dim_a);
+}
+
+bool pointToShapeCheck(const sf::Vector2f point, const ShapeType shape, const sf::Vector2f shape_pos,
+                       const sf::Vector2f shape_dim)
+{
+    if (shape == CIRCLE)
+    {
+        const float radius = std::max(shape_dim.x, shape_dim.y) / 2;
+        const float distance_x = point.x - (shape_pos.x + radius);
+        const float distance_y = point.y - (shape_pos.y + radius);
+        return radius > 0 && distance_x * distance_x + distance_y * distance_y <= radius * radius;
+    }
+    return point.x >= std::min(shape_pos.x, shape_pos.x + shape_dim.x) &&
+           point.x <= std::max(shape_pos.x, shape_pos.x + shape_dim.x) &&
+           point.y >= std::min(shape_pos.y, shape_pos.y + shape_dim.y) &&
+           point.y <= std::max(shape_pos.y, shape_pos.y + shape_dim.y);
+}
+
+bool rayToBoxCheck(const sf::Vector2f origin, const sf::Vector2f direction, const float max_distance,
+                   const float min_x, const float min_y, const float max_x, const float max_y, float &distance)
+{
+    // Slab method, the ray is inside the box between the highest entry and the lowest exit of both axes
+    float entry = 0;
+    float exit = max_distance;
+    const float origins[2] = {origin.x, origin.y};
+    const float directions[2] = {direction.x, direction.y};
+    const float mins[2] = {min_x, min_y};
+    const float maxs[2] = {max_x, max_y};
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (directions[axis] == 0)
+        {
+            // Parallel to the slab, either always or never inside it
+            if (origins[axis] < mins[axis] || origins[axis] > maxs[axis])
+            {
+                return false;
+            }
+            continue;
+        }
+        float near = (mins[axis] - origins[axis]) / directions[axis];
+        float far = (maxs[axis] - origins[axis]) / directions[axis];
+        if (near > far)
+        {
+            std::swap(near, far);
+        }
+        entry = std::max(entry, near);
+        exit = std::min(exit, far);
+        if (entry > exit)
+        {
+            return false;
+        }
+    }
+    distance = entry;
+    return true;
+}
+
+bool rayToShapeCheck(const sf::Vector2f origin, const sf::Vector2f direction, const float max_distance,
+                     const ShapeType shape, const sf::Vector2f shape_pos, const sf::Vector2f shape_dim,
+                     float &distance)
+{
+    if (shape == RECTANGLE)
+    {
+        return rayToBoxCheck(origin, direction, max_distance, std::min(shape_pos.x, shape_pos.x + shape_dim.x),
+                             std::min(shape_pos.y, shape_pos.y + shape_dim.y),
+                             std::max(shape_pos.x, shape_pos.x + shape_dim.x),
+                             std::max(shape_pos.y, shape_pos.y + shape_dim.y), distance);
+    }
+
+    const float radius = std::max(shape_dim.x, shape_dim.y) / 2;
+    if (radius <= 0)
+    {
+        return false;
+    }
+    // Solves |origin + t * direction - center| = radius, direction is normalized
+    const float to_center_x = shape_pos.x + radius - origin.x;
+    const float to_center_y = shape_pos.y + radius - origin.y;
+    const float projection = to_center_x * direction.x + to_center_y * direction.y;
+    const float center_distance = to_center_x * to_center_x + to_center_y * to_center_y;
+    if (center_distance <= radius * radius)
+    {
+        distance = 0;
+        return true;
+    }
+    const float discriminant = projection * projection - center_distance + radius * radius;
+    if (projection < 0 || discriminant < 0)
+    {
+        return false;
+    }
+    distance = projection - std::sqrt(discriminant);
+    return distance <= max_distance;
+}
+
+namespace
+{
+#if defined(__AVX2__)
+struct lanes
+{
+    static constexpr std::size_t width = 8;
+    using vec = __m256;
+
+    static vec set(float value)
+    {
+        return _mm256_set1_ps(value);
+    }
+    static vec gather(const float *base, const int *indices)
+    {
+        return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices)), 4);
+    }
+    static vec gatherCircles(const std::int32_t *base, const int *indices)
+    {
+        const __m256i shapes =
+            _mm256_i32gather_epi32(base, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices)), 4);
+        return _mm256_castsi256_ps(_mm256_cmpeq_epi32(shapes, _mm256_set1_epi32(CIRCLE)));
+    }
+    static vec add(vec a, vec b)
+    {
+        return _mm256_add_ps(a, b);
+    }
+    static vec sub(vec a, vec b)
+    {
+        return _mm256_sub_ps(a, b);
+    }
+    static vec mul(vec a, vec b)
+    {
+        return _mm256_mul_ps(a, b);
+    }
+    static vec greater(vec a, vec b)
+    {
+        return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+    }
+    static vec greaterEqual(vec a, vec b)
+    {
+        return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+    }
+    static vec both(vec a, vec b)
+    {
+        return _mm256_and_ps(a, b);
+    }
+    static vec either(vec a, vec b)
+    {
+        return _mm256_or_ps(a, b);
+    }
+    /// mask ? a : b
+    static vec select(vec mask, vec a, vec b)
+    {
+        return _mm256_blendv_ps(b, a, mask);
+    }
+    static unsigned int bits(vec mask)
+    {
+        return static_cast<unsigned int>(_mm256_movemask_ps(mask));
+    }
+};
+#elif defined(__SSE2__)
+struct lanes
+{
+    static constexpr std::size_t width = 4;
+    using vec = __m128;
+
+    static vec set(float value)
+    {
+        return _mm_set1_ps(value);
+    }
+    static vec gather(const float *base, const int *indices)
+    {
+        return _mm_set_ps(base[indices[3]], base[indices[2]], base[indices[1]], base[indices[0]]);
+    }
+    static vec gatherCircles(const std::int32_t *base, const int *indices)
+    {
+        const __m128i shapes = _mm_set_epi32(base[indices[3]], base[indices[2]], base[indices[1]], base[indices[0]]);
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(shapes, _mm_set1_epi32(CIRCLE)));
+    }
+    static vec add(vec a, vec b)
+    {
+        return _mm_add_ps(a, b);
+    }
+    static vec sub(vec a, vec b)
+    {
+        return _mm_sub_ps(a, b);
+    }
+    static vec mul(vec a, vec b)
+    {
+        return _mm_mul_ps(a, b);
+    }
+    static vec greater(vec a, vec b)
+    {
+        return _mm_cmpgt_ps(a, b);
+    }
+    static vec greaterEqual(vec a, vec b)
+    {
+        return _mm_cmpge_ps(a, b);
+    }
+    static vec both(vec a, vec b)
+    {
+        return _mm_and_ps(a, b);
+    }
+    static vec either(vec a, vec b)
+    {
+        return _mm_or_ps(a, b);
+    }
+    /// mask ? a : b
+    static vec select(vec mask, vec a, vec b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+    static unsigned int bits(vec mask)
+    {
+        return static_cast<unsigned int>(_mm_movemask_ps(mask));
+    }
+};
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__)
+using vec = lanes::vec;
+
+struct lane_shapes
+{
+    vec x, y, width, height;
+};
+
+/// std::max(a, b) / 2, std::max returns a when both are equal
+vec radius(vec a, vec b)
+{
+    return lanes::mul(lanes::select(lanes::greater(b, a), b, a), lanes::set(0.5f));
+}
+
+vec rectangleToRectangle(const lane_shapes &rect1, const lane_shapes &rect2)
+{
+    return lanes::both(
+        lanes::both(lanes::greater(lanes::add(rect1.x, rect1.width), rect2.x),
+                    lanes::greater(lanes::add(rect2.x, rect2.width), rect1.x)),
+        lanes::both(lanes::greater(lanes::add(rect2.y, rect2.height), rect1.y),
+                    lanes::greater(lanes::add(rect1.y, rect1.height), rect2.y)));
+}
+
+vec circleToCircle(const lane_shapes &circ1, const lane_shapes &circ2)
+{
+    const vec circ1_rad = radius(circ1.width, circ1.height);
+    const vec circ2_rad = radius(circ2.width, circ2.height);
+    const vec distance_x = lanes::sub(lanes::add(circ1.x, circ1_rad), lanes::add(circ2.x, circ2_rad));
+    const vec distance_y = lanes::sub(lanes::add(circ1.y, circ1_rad), lanes::add(circ2.y, circ2_rad));
+    const vec radius_sum = lanes::add(circ1_rad, circ2_rad);
+    const vec distance = lanes::add(lanes::mul(distance_x, distance_x), lanes::mul(distance_y, distance_y));
+    return lanes::both(lanes::greater(radius_sum, lanes::set(0)),
+                       lanes::greater(lanes::mul(radius_sum, radius_sum), distance));
+}
+
+vec circleToRectangle(const lane_shapes &circ, const lane_shapes &rect)
+{
+    const vec zero = lanes::set(0);
+    const vec half = lanes::set(0.5f);
+    const vec rad = radius(circ.width, circ.height);
+    const vec center_x = lanes::add(circ.x, rad);
+    const vec center_y = lanes::add(circ.y, rad);
+    const vec right = lanes::add(rect.x, rect.width);
+    const vec bottom = lanes::add(rect.y, rect.height);
+    const vec half_width = lanes::mul(rect.width, half);
+    const vec half_height = lanes::mul(rect.height, half);
+
+    const vec distance_x = lanes::sub(lanes::add(rect.x, half_width), center_x);
+    const vec left = lanes::greaterEqual(distance_x, zero);
+    const vec inside_x = lanes::both(lanes::greaterEqual(right, center_x), lanes::greaterEqual(center_x, rect.x));
+    const vec reach_x = lanes::select(left, lanes::greaterEqual(lanes::add(center_x, rad), rect.x),
+                                      lanes::greater(right, lanes::sub(center_x, rad)));
+
+    const vec distance_y = lanes::sub(lanes::add(rect.y, half_height), center_y);
+    const vec above = lanes::greaterEqual(distance_y, zero);
+    const vec inside_y = lanes::both(lanes::greaterEqual(bottom, center_y), lanes::greaterEqual(center_y, rect.y));
+    const vec reach_y = lanes::select(above, lanes::greaterEqual(lanes::add(center_y, rad), rect.y),
+                                      lanes::greater(bottom, lanes::sub(center_y, rad)));
+
+    const vec corner_x =
+        lanes::select(left, lanes::sub(distance_x, half_width), lanes::add(distance_x, half_width));
+    const vec corner_y =
+        lanes::select(above, lanes::sub(distance_y, half_height), lanes::add(distance_y, half_height));
+    const vec corner = lanes::both(
+        lanes::greater(rad, zero),
+        lanes::greater(lanes::mul(rad, rad),
+                       lanes::add(lanes::mul(corner_x, corner_x), lanes::mul(corner_y, corner_y))));
+
+    return lanes::either(lanes::either(lanes::both(reach_x, inside_y), lanes::both(reach_y, inside_x)), corner);
+}
+#endif
+} // namespace
+
+std::size_t shapesBatchCheck(const shape_buffer &shapes, const int index, const int *candidates,
+                             const std::size_t count, int *hits)
+{
+    const sf::Vector2f position{shapes.x[index], shapes.y[index]};
+    const sf::Vector2f dimensions{shapes.width[index], shapes.height[index]};
+    const auto shape = static_cast<ShapeType>(shapes.shape[index]);
+
+    std::size_t found = 0;
+    std::size_t i = 0;
+
+#if defined(__AVX2__) || defined(__SSE2__)
+    const lane_shapes self{lanes::set(position.x), lanes::set(position.y), lanes::set(dimensions.x),
+                           lanes::set(dimensions.y)};
+    for (; i + lanes::width <= count; i += lanes::width)
+    {
+        const int *batch = candidates + i;
+        const lane_shapes other{lanes::gather(shapes.x.data(), batch), lanes::gather(shapes.y.data(), batch),
+                                lanes::gather(shapes.width.data(), batch), lanes::gather(shapes.height.data(), batch)};
+        const vec circles = lanes::gatherCircles(shapes.shape.data(), batch);
+
+        // Same roles as shapesCheck(other, self)
+        const vec result =
+            shape == RECTANGLE
+                ? lanes::select(circles, circleToRectangle(other, self), rectangleToRectangle(other, self))
+                : lanes::select(circles, circleToCircle(other, self), circleToRectangle(self, other));
+
+        for (unsigned int bits = lanes::bits(result); bits != 0; bits &= bits - 1)
+        {
+            hits[found++] = batch[std::countr_zero(bits)];
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        const int candidate = candidates[i];
+        if (shapesCheck(static_cast<ShapeType>(shapes.shape[candidate]), {shapes.x[candidate], shapes.y[candidate]},
+                        {shapes.width[candidate], shapes.height[candidate]}, shape, position, dimensions))
+        {
+            hits[found++] = candidate;
+        }
+    }
+    return found;
+}
+} // namespace mate
@@ -3,38 +3,244 @@
 //
 
 #include "Basics.h"
+#include "ElementPool.h"
+#include "JobSystem.h"
+#include "Trigger.h"
+#include "WorkerPool.h"
+#include <chrono>
 
 namespace mate
 {
+thread_local sf::Time ILoop::current_delta_time = sf::seconds(1.f / 60);
+thread_local float ILoop::current_interpolation = 1;
+
 [[maybe_unused]] void Room::addElement(std::shared_ptr<Element> element)
 {
     if (weakPtrIsUninitialized(element->getParent()))
         element->setParent(shared_from_this());
+    if (!element->getArena())
+    {
+        element->useArena(_arena);
+    }
+    element->setOwnerRoom(*this);
     _children_loops.push_back(std::move(element));
 }
 
 std::shared_ptr<Element> Room::addElement()
 {
-    auto child_element = std::make_shared<Element>(shared_from_this(), getPosition());
+    auto child_element =
+        std::allocate_shared<Element>(ArenaAllocator<Element>(_arena), shared_from_this(), getPosition());
+    child_element->useArena(_arena);
+    child_element->setOwnerRoom(*this);
     _children_loops.push_back(child_element);
     return std::move(child_element);
 }
 
 void Room::loop()
 {
+    current_delta_time = _delta_time;
+    if (_transform_threads != 1)
+    {
+        propagateTransforms();
+    }
+    if (_trigger_world)
+    {
+        _trigger_world->settings = _trigger_settings;
+    }
+    if (_component_storage)
+    {
+        _component_storage->loop();
+    }
+    if (_loop_threads != 1 && !getTransformStore())
+    {
+        loopElementsParallel();
+    }
+    else
+    {
+        for (const auto &child : _children_loops)
+        {
+            child->loop();
+        }
+    }
+
+    // Sync point of the frame
+    _commands.apply(*this);
+    if (_purge_pending.exchange(false))
+    {
+        _children_loops.remove_if([](auto &child) {
+            if (!child->shouldDestroy())
+            {
+                return false;
+            }
+            // Only destroyed Elements are checked for a pool
+            if (const auto element = std::dynamic_pointer_cast<Element>(child))
+            {
+                if (const auto pool = element->getPool().lock())
+                {
+                    pool->release(element);
+                }
+            }
+            return true;
+        });
+    }
+
+    // Every tick checks the Triggers again, even when several ticks run before the next renderLoop()
+    if (_trigger_world)
+    {
+        Trigger::endTick(*_trigger_world);
+    }
+}
+
+JobSystem &Room::getJobSystem()
+{
+    if (!_jobs)
+    {
+        _jobs = std::make_shared<JobSystem>(_loop_threads);
+    }
+    return *_jobs;
+}
+
+void Room::loopElementsParallel()
+{
+    JobSystem &jobs = getJobSystem();
+    jobs.resize(_loop_threads);
+    // Read by every top Element, brought up to date before the threads share it
+    getWorldTransform();
+
+    _parallel_loops.clear();
+    _sequential_loops.clear();
     for (const auto &child : _children_loops)
+    {
+        // The Room only holds Elements
+        const auto *element = static_cast<const Element *>(child.get());
+        (element->getMainThreadComponentsCount() == 0 ? _parallel_loops : _sequential_loops).push_back(child.get());
+    }
+    jobs.parallelFor(_parallel_loops.size(), [this](const std::size_t i) {
+        current_delta_time = _delta_time;
+        _parallel_loops[i]->loop();
+    });
+    for (ILowLoop *child : _sequential_loops)
     {
         child->loop();
     }
-    _children_loops.remove_if([](auto &child) { return child->shouldDestroy(); });
 }
 
 void Room::renderLoop()
 {
+    current_interpolation = _interpolation;
     for (auto &element : _children_loops)
     {
         element->renderLoop();
     }
+    if (_component_storage)
+    {
+        _component_storage->renderLoop();
+    }
+}
+
+std::size_t Room::propagateTransforms()
+{
+    const auto start = std::chrono::steady_clock::now();
+    WorkerPool *pool = nullptr;
+    if (_transform_threads != 1 && _transform_tree_size >= _transform_parallel_threshold)
+    {
+        if (!_transform_pool)
+        {
+            _transform_pool = std::make_shared<WorkerPool>();
+        }
+        _transform_pool->resize(_transform_threads);
+        pool = _transform_pool.get();
+    }
+    _transform_tree_size = updateWorldTree(pool);
+    _transform_propagation_time =
+        sf::microseconds(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+                             .count());
+    return _transform_tree_size;
+}
+
+std::shared_ptr<trigger_world> Room::getTriggerWorld()
+{
+    if (!_trigger_world)
+    {
+        _trigger_world = std::make_shared<trigger_world>();
+        _trigger_world->room_owned = true;
+    }
+    _trigger_world->settings = _trigger_settings;
+    return _trigger_world;
+}
+
+std::shared_ptr<Trigger> Room::findTrigger(const trigger_handle handle) const
+{
+    return _trigger_world ? Trigger::findTrigger(*_trigger_world, handle) : nullptr;
+}
+
+std::size_t Room::queryPoint(const sf::Vector2f point, std::vector<std::shared_ptr<Trigger>> &result,
+                             const std::uint32_t mask)
+{
+    result.clear();
+    if (!_trigger_world)
+    {
+        return 0;
+    }
+    _trigger_world->settings = _trigger_settings;
+    return Trigger::queryPoint(*_trigger_world, point, result, mask);
+}
+
+std::size_t Room::queryRect(const sf::FloatRect &rect, std::vector<std::shared_ptr<Trigger>> &result,
+                            const std::uint32_t mask)
+{
+    result.clear();
+    if (!_trigger_world)
+    {
+        return 0;
+    }
+    _trigger_world->settings = _trigger_settings;
+    return Trigger::queryShape(*_trigger_world, RECTANGLE, rect.getPosition(), rect.getSize(), result, mask);
+}
+
+std::size_t Room::queryCircle(const sf::Vector2f center, const float radius,
+                              std::vector<std::shared_ptr<Trigger>> &result, const std::uint32_t mask)
+{
+    result.clear();
+    if (!_trigger_world)
+    {
+        return 0;
+    }
+    _trigger_world->settings = _trigger_settings;
+    // Circle shapes are stored by their bounding box
+    return Trigger::queryShape(*_trigger_world, CIRCLE, center - sf::Vector2f(radius, radius),
+                               {2 * radius, 2 * radius}, result, mask);
+}
+
+bool Room::raycast(const sf::Vector2f origin, const sf::Vector2f direction, const float max_distance,
+                   raycast_hit &hit, const std::uint32_t mask)
+{
+    thread_local std::vector<raycast_hit> hits;
+    if (castRay(origin, direction, max_distance, hits, mask, true) == 0)
+    {
+        return false;
+    }
+    hit = std::move(hits.front());
+    hits.clear();
+    return true;
+}
+
+std::size_t Room::raycastAll(const sf::Vector2f origin, const sf::Vector2f direction, const float max_distance,
+                             std::vector<raycast_hit> &hits, const std::uint32_t mask)
+{
+    return castRay(origin, direction, max_distance, hits, mask, false);
+}
+
+std::size_t Room::castRay(const sf::Vector2f origin, const sf::Vector2f direction, const float max_distance,
+                          std::vector<raycast_hit> &hits, const std::uint32_t mask, const bool first_only)
+{
+    hits.clear();
+    if (!_trigger_world)
+    {
+        return 0;
+    }
+    _trigger_world->settings = _trigger_settings;
+    return Trigger::raycast(*_trigger_world, origin, direction, max_distance, first_only, hits, mask);
 }
 
 [[maybe_unused]] void Room::windowResizeEvent()
@@ -43,5 +249,9 @@ void Room::renderLoop()
     {
         element->windowResizeEvent();
     }
+    if (_component_storage)
+    {
+        _component_storage->windowResizeEvent();
+    }
 }
 } // namespace mate
@@ -0,0 +1,77 @@
+/**
+ * @brief RoomArena class methods definitions
+ * @file RoomArena.cpp
+ */
+
+#include "RoomArena.h"
+
+namespace mate
+{
+RoomArena::RoomArena()
+{
+    for (std::size_t i = 0; i < std::size(size_classes); ++i)
+    {
+        _pools[i].block_size = size_classes[i];
+    }
+}
+
+RoomArena::pool *RoomArena::findPool(const std::size_t bytes, const std::size_t alignment)
+{
+    if (alignment > alignof(std::max_align_t))
+    {
+        return nullptr;
+    }
+    for (auto &pool : _pools)
+    {
+        if (bytes <= pool.block_size)
+        {
+            return &pool;
+        }
+    }
+    return nullptr;
+}
+
+void RoomArena::refill(pool &pool)
+{
+    // new[] aligns to std::max_align_t, and every size class is a multiple of it
+    _chunks.push_back(std::make_unique<std::byte[]>(chunk_bytes));
+    std::byte *chunk = _chunks.back().get();
+    for (std::size_t offset = chunk_bytes; offset >= pool.block_size; offset -= pool.block_size)
+    {
+        auto *block = reinterpret_cast<free_block *>(chunk + offset - pool.block_size);
+        block->next = pool.free_list;
+        pool.free_list = block;
+    }
+}
+
+void *RoomArena::allocate(const std::size_t bytes, const std::size_t alignment)
+{
+    pool *pool = findPool(bytes, alignment);
+    if (!pool)
+    {
+        return ::operator new(bytes, std::align_val_t(alignment));
+    }
+    if (!pool->free_list)
+    {
+        refill(*pool);
+    }
+    free_block *block = pool->free_list;
+    pool->free_list = block->next;
+    ++_used_blocks;
+    return block;
+}
+
+void RoomArena::deallocate(void *pointer, const std::size_t bytes, const std::size_t alignment) noexcept
+{
+    pool *pool = findPool(bytes, alignment);
+    if (!pool)
+    {
+        ::operator delete(pointer, std::align_val_t(alignment));
+        return;
+    }
+    auto *block = static_cast<free_block *>(pointer);
+    block->next = pool->free_list;
+    pool->free_list = block;
+    --_used_blocks;
+}
+} // namespace mate
@@ -0,0 +1,112 @@
+/**
+ * @brief SpatialHash class methods definitions
+ * @file SpatialHash.cpp
+ */
+
+#include "SpatialHash.h"
+#include <algorithm>
+#include <cmath>
+
+namespace mate
+{
+SpatialHash::SpatialHash(float cell_size) : _cell_size(cell_size > 0 ? cell_size : 64.0f)
+{
+}
+
+void SpatialHash::setCellSize(float cell_size)
+{
+    if (cell_size <= 0 || cell_size == _cell_size)
+    {
+        return;
+    }
+    _cell_size = cell_size;
+    _cells.clear();
+    _oversized.clear();
+    _ids.clear();
+}
+
+void SpatialHash::clear()
+{
+    std::erase_if(_cells, [](const auto &cell) { return cell.second.empty(); });
+    for (auto &cell : _cells)
+    {
+        cell.second.clear();
+    }
+    _oversized.clear();
+    _ids.clear();
+}
+
+bool SpatialHash::getCellRange(const sf::FloatRect &bounds, cell_range &range) const
+{
+    // Keeps the cell coordinates far from the int32 limits
+    constexpr float max_cell = 1 << 30;
+
+    const float min_x = std::floor(bounds.left / _cell_size);
+    const float min_y = std::floor(bounds.top / _cell_size);
+    const float max_x = std::floor((bounds.left + bounds.width) / _cell_size);
+    const float max_y = std::floor((bounds.top + bounds.height) / _cell_size);
+
+    // Written so NaN values fail the check
+    if (!(min_x >= -max_cell && min_y >= -max_cell && max_x <= max_cell && max_y <= max_cell && min_x <= max_x &&
+          min_y <= max_y))
+    {
+        return false;
+    }
+    if ((max_x - min_x + 1) * (max_y - min_y + 1) > static_cast<float>(max_cells_per_entry))
+    {
+        return false;
+    }
+
+    range = {static_cast<std::int32_t>(min_x), static_cast<std::int32_t>(min_y), static_cast<std::int32_t>(max_x),
+             static_cast<std::int32_t>(max_y)};
+    return true;
+}
+
+void SpatialHash::insert(unsigned int id, const sf::FloatRect &bounds)
+{
+    _ids.push_back(id);
+
+    cell_range range{};
+    if (!getCellRange(bounds, range))
+    {
+        _oversized.push_back(id);
+        return;
+    }
+
+    for (std::int32_t x = range.min_x; x <= range.max_x; ++x)
+    {
+        for (std::int32_t y = range.min_y; y <= range.max_y; ++y)
+        {
+            _cells[getKey(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialHash::query(const sf::FloatRect &bounds, std::vector<unsigned int> &result) const
+{
+    result.clear();
+
+    cell_range range{};
+    if (!getCellRange(bounds, range))
+    {
+        result = _ids;
+    }
+    else
+    {
+        result.insert(result.end(), _oversized.begin(), _oversized.end());
+        for (std::int32_t x = range.min_x; x <= range.max_x; ++x)
+        {
+            for (std::int32_t y = range.min_y; y <= range.max_y; ++y)
+            {
+                if (auto cell = _cells.find(getKey(x, y)); cell != _cells.end())
+                {
+                    result.insert(result.end(), cell->second.begin(), cell->second.end());
+                }
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+}
+} // namespace mate
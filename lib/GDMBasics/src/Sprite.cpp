@@ -2,16 +2,35 @@
 // Created by elly_sparky on 23/01/24.
 //
 #include "Sprite.h"
+#include <cmath>
 
 namespace mate
 {
+namespace
+{
+/**
+ * @return signed angle in degrees, in [-180, 180), that turns the rotation from into to the short way around.
+ */
+float shortestRotation(const float from, const float to)
+{
+    const float delta = std::fmod(to - from, 360.f);
+    if (delta >= 180.f)
+    {
+        return delta - 360.f;
+    }
+    if (delta < -180.f)
+    {
+        return delta + 360.f;
+    }
+    return delta;
+}
+} // namespace
+
 Sprite::Sprite(const std::weak_ptr<Element> &parent) : Component(parent)
 {
     _sprite = std::make_shared<ord_sprite>();
     //_texture.loadFromFile("../Square.png");
     _sprite->sprite.setTexture(_texture, true);
-    auto spt_game = Game::getGame();
-    _game_manager = spt_game;
 }
 
 [[maybe_unused]] void Sprite::addDepth(int depth)
@@ -35,12 +54,38 @@ void Sprite::loop()
 {
     if (_actualize)
     {
-        if (std::shared_ptr<LocalCoords> spt_parent = _parent.lock())
+        if (LocalCoords *parent = getParentCoords())
         {
-            _sprite->sprite.setScale(offset.getDimensionBounds(spt_parent->getWorldScale()));
-            _sprite->sprite.setRotation(spt_parent->getWorldRotation());
-            _sprite->sprite.setPosition(offset.getPositionBounds(spt_parent->getWorldPosition()));
+            _previous_scale = _current_scale;
+            _previous_rotation = _current_rotation;
+            _previous_position = _current_position;
+            _current_scale = offset.getDimensionBounds(parent->getWorldScale());
+            _current_rotation = parent->getWorldRotation();
+            _current_position = offset.getPositionBounds(parent->getWorldPosition());
+            if (!_has_previous)
+            {
+                _previous_scale = _current_scale;
+                _previous_rotation = _current_rotation;
+                _previous_position = _current_position;
+                _has_previous = true;
+            }
+            _sprite->sprite.setScale(_current_scale);
+            _sprite->sprite.setRotation(_current_rotation);
+            _sprite->sprite.setPosition(_current_position);
         }
     }
 }
+
+void Sprite::renderLoop()
+{
+    if (!_interpolate || !_actualize || !_has_previous)
+    {
+        return;
+    }
+    const float alpha = getInterpolation();
+    const float rotation_delta = shortestRotation(_previous_rotation, _current_rotation);
+    _sprite->sprite.setScale(_previous_scale + (_current_scale - _previous_scale) * alpha);
+    _sprite->sprite.setRotation(_previous_rotation + rotation_delta * alpha);
+    _sprite->sprite.setPosition(_previous_position + (_current_position - _previous_position) * alpha);
+}
 } // namespace mate
@@ -0,0 +1,65 @@
+/**
+ * @brief StaticTree class methods definitions
+ * @file StaticTree.cpp
+ */
+
+#include "StaticTree.h"
+#include <algorithm>
+
+namespace mate
+{
+void StaticTree::build(std::vector<item> items)
+{
+    _items = std::move(items);
+    _nodes.clear();
+    if (!_items.empty())
+    {
+        _nodes.reserve(2 * (_items.size() / leaf_size + 1));
+        buildNode(0, static_cast<int>(_items.size()));
+    }
+}
+
+int StaticTree::buildNode(const int begin, const int end)
+{
+    const int index = static_cast<int>(_nodes.size());
+    _nodes.push_back({});
+
+    node bounds{_items[begin].bounds.left, _items[begin].bounds.top, _items[begin].bounds.left,
+                _items[begin].bounds.top, begin, end - begin};
+    const sf::FloatRect &first = _items[begin].bounds;
+    float center_min_x = first.left + first.width / 2, center_max_x = center_min_x;
+    float center_min_y = first.top + first.height / 2, center_max_y = center_min_y;
+    for (int i = begin; i < end; ++i)
+    {
+        const sf::FloatRect &current = _items[i].bounds;
+        bounds.min_x = std::min(bounds.min_x, current.left);
+        bounds.min_y = std::min(bounds.min_y, current.top);
+        bounds.max_x = std::max(bounds.max_x, current.left + current.width);
+        bounds.max_y = std::max(bounds.max_y, current.top + current.height);
+
+        const float center_x = current.left + current.width / 2;
+        const float center_y = current.top + current.height / 2;
+        center_min_x = std::min(center_min_x, center_x);
+        center_max_x = std::max(center_max_x, center_x);
+        center_min_y = std::min(center_min_y, center_y);
+        center_max_y = std::max(center_max_y, center_y);
+    }
+
+    if (end - begin > leaf_size)
+    {
+        // Median split on the axis where the centers are more spread
+        const bool split_x = center_max_x - center_min_x >= center_max_y - center_min_y;
+        const int middle = begin + (end - begin) / 2;
+        std::nth_element(_items.begin() + begin, _items.begin() + middle, _items.begin() + end,
+                         [split_x](const item &a, const item &b) {
+                             return split_x ? a.bounds.left + a.bounds.width / 2 < b.bounds.left + b.bounds.width / 2
+                                            : a.bounds.top + a.bounds.height / 2 < b.bounds.top + b.bounds.height / 2;
+                         });
+        buildNode(begin, middle);
+        bounds.first = buildNode(middle, end);
+        bounds.count = 0;
+    }
+    _nodes[index] = bounds;
+    return index;
+}
+} // namespace mate
@@ -0,0 +1,103 @@
+/**
+ * @brief SweepAndPrune class methods definitions
+ * @file SweepAndPrune.cpp
+ */
+
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+namespace mate
+{
+void SweepAndPrune::insert(int id, const sf::FloatRect &bounds)
+{
+    if (_positions.size() <= static_cast<std::size_t>(id))
+    {
+        _positions.resize(id + 1, -1);
+    }
+    _positions[id] = static_cast<int>(_entries.size());
+    _entries.push_back({bounds.left, bounds.left + bounds.width, bounds.top, bounds.top + bounds.height, id});
+}
+
+void SweepAndPrune::remove(int id)
+{
+    _entries[_positions[id]].id = -1;
+    _positions[id] = -1;
+    ++_removed_count;
+    // Only updated while it's the selected broad-phase, churn of the others must not pile up entries
+    if (_removed_count * 2 > _entries.size())
+    {
+        compact();
+    }
+}
+
+void SweepAndPrune::compact()
+{
+    std::size_t kept = 0;
+    std::size_t sorted_kept = 0;
+    for (std::size_t i = 0; i < _entries.size(); ++i)
+    {
+        if (_entries[i].id == -1)
+        {
+            continue;
+        }
+        if (i < _sorted_count)
+        {
+            ++sorted_kept;
+        }
+        _positions[_entries[i].id] = static_cast<int>(kept);
+        _entries[kept++] = _entries[i];
+    }
+    _entries.resize(kept);
+    _sorted_count = sorted_kept;
+    _removed_count = 0;
+}
+
+void SweepAndPrune::setBounds(int id, const sf::FloatRect &bounds)
+{
+    entry &current = _entries[_positions[id]];
+    current.min_x = bounds.left;
+    current.max_x = bounds.left + bounds.width;
+    current.min_y = bounds.top;
+    current.max_y = bounds.top + bounds.height;
+}
+
+unsigned long SweepAndPrune::update()
+{
+    if (_removed_count > 0)
+    {
+        compact();
+    }
+
+    unsigned long swaps = 0;
+    for (std::size_t i = 1; i < _sorted_count; ++i)
+    {
+        const entry current = _entries[i];
+        std::size_t j = i;
+        for (; j > 0 && _entries[j - 1].min_x > current.min_x; --j)
+        {
+            _entries[j] = _entries[j - 1];
+            _positions[_entries[j].id] = static_cast<int>(j);
+            ++swaps;
+        }
+        if (j != i)
+        {
+            _entries[j] = current;
+            _positions[current.id] = static_cast<int>(j);
+        }
+    }
+
+    if (_sorted_count < _entries.size())
+    {
+        const auto by_min_x = [](const entry &a, const entry &b) { return a.min_x < b.min_x; };
+        const auto inserted = _entries.begin() + static_cast<std::ptrdiff_t>(_sorted_count);
+        std::sort(inserted, _entries.end(), by_min_x);
+        std::inplace_merge(_entries.begin(), inserted, _entries.end(), by_min_x);
+        for (std::size_t i = 0; i < _entries.size(); ++i)
+        {
+            _positions[_entries[i].id] = static_cast<int>(i);
+        }
+        _sorted_count = _entries.size();
+    }
+    return swaps;
+}
+} // namespace mate
@@ -0,0 +1,221 @@
+/**
+ * @brief TransformStore class methods definitions
+ * @file TransformStore.cpp
+ */
+
+#include "TransformStore.h"
+#include <algorithm>
+
+namespace mate
+{
+int TransformStore::add(const int parent)
+{
+    int node;
+    if (!_free_ids.empty())
+    {
+        node = _free_ids.back();
+        _free_ids.pop_back();
+    }
+    else
+    {
+        node = static_cast<int>(_positions.size());
+        _positions.push_back(-1);
+        _parent_ids.push_back(-1);
+    }
+
+    // Appended after everything else, so after its parent too
+    const int position = static_cast<int>(_ids.size());
+    _ids.push_back(node);
+    _parents.push_back(parent < 0 ? -1 : _positions[parent]);
+    _local.resize(_ids.size());
+    _world.resize(_ids.size());
+    _local.set(position, sf::Transform::Identity, {1, 1}, 0);
+    _positions[node] = position;
+    _parent_ids[node] = parent;
+    _dirty_from = std::min(_dirty_from, static_cast<std::size_t>(position));
+    return node;
+}
+
+void TransformStore::remove(const int node)
+{
+    _ids[_positions[node]] = -1;
+    _positions[node] = -1;
+    _parent_ids[node] = -1;
+    _released_ids.push_back(node);
+    ++_holes;
+    _order_dirty = true;
+}
+
+void TransformStore::setParent(const int node, const int parent)
+{
+    _parent_ids[node] = parent;
+    const int parent_position = parent < 0 ? -1 : _positions[parent];
+    if (parent_position > _positions[node])
+    {
+        _order_dirty = true;
+    }
+    _parents[_positions[node]] = parent_position;
+    _dirty_from = std::min(_dirty_from, static_cast<std::size_t>(_positions[node]));
+}
+
+void TransformStore::setLocal(const int node, const sf::Transform &transform, const sf::Vector2f scale,
+                              const float rotation)
+{
+    _local.set(_positions[node], transform, scale, rotation);
+    // Its descendants come after it
+    _dirty_from = std::min(_dirty_from, static_cast<std::size_t>(_positions[node]));
+}
+
+void TransformStore::reorder()
+{
+    // Children of every node in their current order
+    std::vector<int> offsets(_positions.size() + 1, 0);
+    std::vector<int> roots;
+    for (const int node : _ids)
+    {
+        if (node < 0)
+        {
+            continue;
+        }
+        const int parent = _parent_ids[node];
+        if (parent < 0 || _positions[parent] < 0)
+        {
+            // Removed parents leave their children as roots
+            _parent_ids[node] = -1;
+            roots.push_back(node);
+        }
+        else
+        {
+            ++offsets[parent + 1];
+        }
+    }
+    for (std::size_t i = 1; i < offsets.size(); ++i)
+    {
+        offsets[i] += offsets[i - 1];
+    }
+    std::vector<int> children(offsets.back());
+    std::vector<int> filled(offsets.begin(), offsets.end() - 1);
+    for (const int node : _ids)
+    {
+        if (node >= 0 && _parent_ids[node] >= 0)
+        {
+            children[filled[_parent_ids[node]]++] = node;
+        }
+    }
+
+    // Depth first, keeping every subtree contiguous
+    const std::size_t size = _ids.size() - _holes;
+    transform_buffer local;
+    local.resize(size);
+    std::vector<int> ids;
+    std::vector<int> parents;
+    ids.reserve(size);
+    parents.reserve(size);
+    std::vector<int> stack;
+    for (auto root = roots.rbegin(); root != roots.rend(); ++root)
+    {
+        stack.push_back(*root);
+    }
+    while (!stack.empty())
+    {
+        const int node = stack.back();
+        stack.pop_back();
+        const int position = static_cast<int>(ids.size());
+        local.copy(position, _local, _positions[node]);
+        ids.push_back(node);
+        const int parent = _parent_ids[node];
+        // The parent was placed before, its position is already updated
+        parents.push_back(parent < 0 ? -1 : _positions[parent]);
+        _positions[node] = position;
+        for (int child = offsets[node + 1] - 1; child >= offsets[node]; --child)
+        {
+            stack.push_back(children[child]);
+        }
+    }
+
+    _local = std::move(local);
+    _ids = std::move(ids);
+    _parents = std::move(parents);
+    _world.resize(size);
+    _free_ids.insert(_free_ids.end(), _released_ids.begin(), _released_ids.end());
+    _released_ids.clear();
+    _holes = 0;
+    _order_dirty = false;
+    _dirty_from = 0;
+}
+
+void TransformStore::update()
+{
+    if (_order_dirty)
+    {
+        reorder();
+    }
+    computeWorld(_ids.size());
+}
+
+void TransformStore::computeWorld(const std::size_t end)
+{
+    if (_dirty_from >= end)
+    {
+        return;
+    }
+
+    const int *parents = _parents.data();
+    const transform_buffer &l = _local;
+    transform_buffer &w = _world;
+    for (std::size_t i = _dirty_from; i < end; ++i)
+    {
+        const int p = parents[i];
+        if (p < 0)
+        {
+            w.copy(i, l, i);
+            continue;
+        }
+        // Parent world * local, the parent was already computed
+        w.m00[i] = w.m00[p] * l.m00[i] + w.m01[p] * l.m10[i];
+        w.m01[i] = w.m00[p] * l.m01[i] + w.m01[p] * l.m11[i];
+        w.m02[i] = w.m00[p] * l.m02[i] + w.m01[p] * l.m12[i] + w.m02[p];
+        w.m10[i] = w.m10[p] * l.m00[i] + w.m11[p] * l.m10[i];
+        w.m11[i] = w.m10[p] * l.m01[i] + w.m11[p] * l.m11[i];
+        w.m12[i] = w.m10[p] * l.m02[i] + w.m11[p] * l.m12[i] + w.m12[p];
+        w.scale_x[i] = w.scale_x[p] * l.scale_x[i];
+        w.scale_y[i] = w.scale_y[p] * l.scale_y[i];
+        w.rotation[i] = w.rotation[p] + l.rotation[i];
+    }
+    _dirty_from = end;
+}
+
+int TransformStore::updateNode(const int node)
+{
+    if (_order_dirty)
+    {
+        reorder();
+    }
+    // Its ancestors come before it
+    const int position = _positions[node];
+    computeWorld(position + 1);
+    return position;
+}
+
+sf::Transform TransformStore::getWorldTransform(const int node)
+{
+    return _world.getTransform(updateNode(node));
+}
+
+sf::Vector2f TransformStore::getWorldPosition(const int node)
+{
+    const int position = updateNode(node);
+    return {_world.m02[position], _world.m12[position]};
+}
+
+sf::Vector2f TransformStore::getWorldScale(const int node)
+{
+    const int position = updateNode(node);
+    return {_world.scale_x[position], _world.scale_y[position]};
+}
+
+float TransformStore::getWorldRotation(const int node)
+{
+    return _world.rotation[updateNode(node)];
+}
+} // namespace mate
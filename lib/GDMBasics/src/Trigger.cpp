@@ -4,72 +4,730 @@
 */
 
 #include "Trigger.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 
 namespace mate
 {
-	/**
-	 * Checks superposition between two rectangle shapes
-	 * @param rect1_pos position of the first rectangle's left top corner
-	 * @param rect1_dim scale of the first rectangle
-	 * @param rect2_pos position of the second rectangle's left top corner
-	 * @param rect2_dim scale of the second rectangle
-	 * @return true if superposed, false otherwise
-	 */
-	bool rectangleToRectangleCheck(sf::Vector2f rect1_pos, sf::Vector2f rect1_dim, sf::Vector2f rect2_pos, sf::Vector2f rect2_dim);
-
-	/**
-	 * Checks superposition between a rectangle shape and a circle shape
-	 * @param circ_pos center of the circle
-	 * @param circ_dim scale of the circle (only the biggest of it's two dimensions will be used)
-	 * @param rect_pos position of the rectangle's left top corner
-	 * @param rect_dim scale of the rectangle
-	 * @return true if superposed, false otherwise
-	 */
-	bool circleToRectangleCheck(sf::Vector2f circ_pos, sf::Vector2f circ_dim, sf::Vector2f rect_pos, sf::Vector2f rect_dim);
-
-	/**
-	 * Checks superposition between two circle shapes
-	 * @param circ1_pos center of the first circle
-	 * @param circ1_dim scale of the first circle (only the biggest dimension will be used)
-	 * @param circ2_pos center of the second circle
-	 * @param circ2_dim scale of the second circle (only the biggest dimension will be used)
-	 * @return true if superposed, false otherwise
-	 */
-	bool circleToCircleCheck(sf::Vector2f circ1_pos, sf::Vector2f circ1_dim, sf::Vector2f circ2_pos, sf::Vector2f circ2_dim);
-
-	std::list<std::weak_ptr<Trigger>> Trigger::active_triggers = {};
+	thread_local std::shared_ptr<trigger_world> Trigger::detached_world = std::make_shared<trigger_world>();
 
 	Trigger::Trigger(const std::weak_ptr<Element> &parent) : Component(parent)
 	{
-		checked = false;
 		active = false;
 	}
 
-	void Trigger::runChecks()
+	Trigger::~Trigger()
 	{
-		for (auto it = active_triggers.begin(); it != active_triggers.end();)
+		// The entry can't be reached anymore, the proxy is released right away instead of waiting for a purge
+		if (active)
+		{
+			if (const auto current = world.lock())
+			{
+				removeProxy(*current, handle.proxy);
+			}
+		}
+	}
+
+	void Trigger::runChecks(trigger_world &world)
+	{
+		switch (world.settings.broad_phase)
+		{
+		case BRUTE_FORCE:
+			runBruteForceChecks(world);
+			break;
+		case SPATIAL_HASH:
+		case DYNAMIC_TREE:
+		case SWEEP_AND_PRUNE:
+			runBroadPhaseChecks(world);
+			break;
+		}
+		checked_frame = world.contacts_frame;
+	}
+
+	void Trigger::runBruteForceChecks(trigger_world &world)
+	{
+		// Indexed loop, fireTrigger may subscribe new Triggers
+		const auto self = shared_from_this();
+		for (std::size_t slot = 0; slot < world.subscribed.size(); ++slot)
 		{
-			if (it->expired())
+			if (world.subscribed[slot] < 0)
 			{
-				it = active_triggers.erase(it);
 				continue;
 			}
-			if (auto trigger = it->lock();
-				!trigger->wasChecked() && trigger != shared_from_this())
+			if (auto trigger = world.proxy_entries[world.subscribed[slot]].trigger.lock();
+				trigger && !trigger->checkedOn(world) && trigger != self)
+			{
+				checkTrigger(world, trigger, self);
+			}
+		}
+	}
+
+	void Trigger::runBroadPhaseChecks(trigger_world &world)
+	{
+		updateBroadPhase(world);
+		if (!world.moved_proxies.empty())
+		{
+			prepareQueries(world);
+		}
+		if (world.pairs_stale)
+		{
+			runStaleChecks(world);
+			return;
+		}
+
+		// Contacts are sorted by subscription order, so fireTrigger is called on the same order as in
+		// runBruteForceChecks
+		const auto self = shared_from_this();
+		const int proxy = handle.proxy;
+		for (unsigned int i = world.contact_pairs_offsets[proxy]; i < world.contact_pairs_offsets[proxy + 1]; ++i)
+		{
+			if (auto trigger = world.proxy_entries[world.contact_pairs[i]].trigger.lock();
+				trigger && trigger->active && !trigger->checkedOn(world) && trigger != self)
+			{
+				fireContact(world, trigger, self);
+			}
+		}
+	}
+
+	void Trigger::runStaleChecks(trigger_world &world)
+	{
+		const auto self = shared_from_this();
+		const sf::FloatRect bounds = getBounds();
+		std::vector<int> &candidates = world.stale_candidates;
+		candidates.clear();
+		world.broad_phase_tree.query(bounds, [&world, &candidates](const int leaf) {
+			candidates.push_back(world.leaf_proxies[leaf]);
+		});
+		if (!is_static)
+		{
+			world.static_tree.query(bounds, [&candidates](const int proxy) { candidates.push_back(proxy); });
+		}
+		std::sort(candidates.begin(), candidates.end(), [&world](const int proxy_a, const int proxy_b) {
+			return world.proxy_entries[proxy_a].order < world.proxy_entries[proxy_b].order;
+		});
+
+		// Indexed loop, fireTrigger may subscribe new Triggers
+		for (std::size_t i = 0; i < candidates.size(); ++i)
+		{
+			if (auto trigger = world.proxy_entries[candidates[i]].trigger.lock();
+				trigger && trigger->active && !trigger->checkedOn(world) && trigger != self)
 			{
-				checkTrigger(trigger, shared_from_this());
+				checkTrigger(world, trigger, self);
 			}
-			++it;
 		}
-		checked = true;
+	}
+
+	void Trigger::markMoved(trigger_world &world, const int proxy)
+	{
+		// Both get fully refreshed on their next use
+		if (world.broad_phase_dirty && world.query_tree_dirty)
+		{
+			return;
+		}
+		trigger_world::proxy_entry &entry = world.proxy_entries[proxy];
+		if (!entry.moved)
+		{
+			entry.moved = true;
+			world.moved_proxies.push_back(proxy);
+		}
+	}
+
+	void Trigger::boundsChanged()
+	{
+		if (!active || is_static)
+		{
+			return;
+		}
+		if (const auto current = world.lock())
+		{
+			markMoved(*current, handle.proxy);
+		}
+	}
+
+	void Trigger::onParentMoved()
+	{
+		boundsChanged();
+	}
+
+	void Trigger::updateBroadPhase(trigger_world &world)
+	{
+		// The pairs are rebuilt when the frame, the subscriptions or the settings change
+		if (world.broad_phase_dirty || world.built_settings != world.settings)
+		{
+			buildBroadPhase(world);
+			world.built_settings = world.settings;
+		}
+	}
+
+	void Trigger::buildBroadPhase(trigger_world &world)
+	{
+		const trigger_settings &settings = world.settings;
+
+		// Compaction of subscribed, the released proxies can be reused from now on
+		if (!world.released_proxies.empty())
+		{
+			std::size_t kept = 0;
+			for (const int proxy : world.subscribed)
+			{
+				if (proxy >= 0)
+				{
+					world.proxy_entries[proxy].slot = static_cast<int>(kept);
+					world.subscribed[kept++] = proxy;
+				}
+			}
+			world.subscribed.resize(kept);
+			world.free_proxies.insert(world.free_proxies.end(), world.released_proxies.begin(),
+			                          world.released_proxies.end());
+			world.released_proxies.clear();
+		}
+
+		if (settings.broad_phase == SPATIAL_HASH)
+		{
+			world.broad_phase.setCellSize(settings.cell_size);
+			world.broad_phase.clear();
+		}
+		world.broad_phase_tree.setMargin(settings.fat_margin);
+		world.shapes.resize(world.proxy_entries.size());
+		world.proxy_checked.assign(world.proxy_entries.size(), false);
+		if (world.static_dirty)
+		{
+			buildStaticIndex(world);
+		}
+
+		for (const int proxy : world.subscribed)
+		{
+			// Static Triggers are already on static_tree and never make their own queries
+			if (world.proxy_entries[proxy].is_static)
+			{
+				continue;
+			}
+			const auto trigger = world.proxy_entries[proxy].trigger.lock();
+
+			const sf::Vector2f position = trigger->getPosition();
+			const sf::Vector2f dimensions = trigger->getDimensions();
+			world.shapes.set(proxy, position, dimensions, trigger->shape);
+			world.proxy_checked[proxy] = trigger->checkedOn(world);
+			world.proxy_entries[proxy].category = trigger->category;
+			world.proxy_entries[proxy].collision_mask = trigger->collision_mask;
+
+			const sf::FloatRect bounds = shapeBounds(trigger->shape, position, dimensions);
+			switch (settings.broad_phase)
+			{
+			case SPATIAL_HASH:
+				world.broad_phase.insert(proxy, bounds);
+				break;
+			case DYNAMIC_TREE:
+				// Refit, only the leaves that left their fat bounds change the tree
+				world.broad_phase_tree.moveProxy(world.proxy_entries[proxy].leaf, bounds);
+				break;
+			case SWEEP_AND_PRUNE:
+				world.sweep_and_prune.setBounds(proxy, bounds);
+				break;
+			case BRUTE_FORCE:
+				break;
+			}
+		}
+
+		world.proxy_pairs_buffer.clear();
+		switch (settings.broad_phase)
+		{
+		case SPATIAL_HASH:
+			// Every pair is found by both Triggers, only the one subscribed first keeps it
+			for (const int proxy : world.subscribed)
+			{
+				if (world.proxy_entries[proxy].is_static)
+				{
+					continue;
+				}
+				world.broad_phase.query(proxyBounds(world, proxy), world.broad_phase_candidates);
+				for (const unsigned int candidate : world.broad_phase_candidates)
+				{
+					if (world.proxy_entries[candidate].order > world.proxy_entries[proxy].order)
+					{
+						addProxyPair(world, proxy, static_cast<int>(candidate));
+					}
+				}
+			}
+			break;
+		case DYNAMIC_TREE:
+			world.broad_phase_tree.queryPairs([&world](const int leaf_a, const int leaf_b) {
+				addProxyPair(world, world.leaf_proxies[leaf_a], world.leaf_proxies[leaf_b]);
+			});
+			break;
+		case SWEEP_AND_PRUNE:
+			world.sweep_and_prune.update();
+			world.sweep_and_prune.queryPairs(
+			    settings.sweep_second_axis,
+			    [&world](const int proxy_a, const int proxy_b) { addProxyPair(world, proxy_a, proxy_b); });
+			break;
+		case BRUTE_FORCE:
+			break;
+		}
+
+		// Dynamic against static pairs
+		if (world.static_tree.size() > 0)
+		{
+			for (const int proxy : world.subscribed)
+			{
+				if (world.proxy_entries[proxy].is_static)
+				{
+					continue;
+				}
+				world.static_tree.query(proxyBounds(world, proxy), [&world, proxy](const int static_proxy) {
+					addProxyPair(world, proxy, static_proxy);
+				});
+			}
+		}
+
+		groupPairs(world, world.proxy_pairs_buffer, false, world.proxy_pairs, world.proxy_pairs_offsets);
+		runNarrowPhase(world);
+		world.broad_phase_dirty = false;
+		world.query_tree_dirty = settings.broad_phase != DYNAMIC_TREE;
+
+		// The positions were read after every move queued so far
+		for (const int proxy : world.moved_proxies)
+		{
+			world.proxy_entries[proxy].moved = false;
+		}
+		world.moved_proxies.clear();
+		world.pairs_stale = false;
+	}
+
+	void Trigger::prepareQueries(trigger_world &world)
+	{
+		if (world.query_tree_dirty)
+		{
+			// Only the shapes and the trees are refreshed, the pairs and contacts of the tick are left untouched
+			world.shapes.resize(world.proxy_entries.size());
+			if (world.static_dirty)
+			{
+				buildStaticIndex(world);
+			}
+			for (const int proxy : world.subscribed)
+			{
+				// Slots of the Triggers that unsubscribed since the last build are empty
+				if (proxy < 0 || world.proxy_entries[proxy].is_static)
+				{
+					continue;
+				}
+				const auto trigger = world.proxy_entries[proxy].trigger.lock();
+
+				const sf::Vector2f position = trigger->getPosition();
+				const sf::Vector2f dimensions = trigger->getDimensions();
+				world.shapes.set(proxy, position, dimensions, trigger->shape);
+				world.proxy_entries[proxy].category = trigger->category;
+				world.proxy_entries[proxy].collision_mask = trigger->collision_mask;
+				world.broad_phase_tree.moveProxy(world.proxy_entries[proxy].leaf,
+				                                 shapeBounds(trigger->shape, position, dimensions));
+			}
+			world.query_tree_dirty = false;
+		}
+
+		// Triggers moved since, the ones refreshed above just get read again
+		for (const int proxy : world.moved_proxies)
+		{
+			trigger_world::proxy_entry &entry = world.proxy_entries[proxy];
+			if (!entry.moved)
+			{
+				continue;
+			}
+			entry.moved = false;
+			if (const auto trigger = entry.trigger.lock())
+			{
+				const sf::Vector2f position = trigger->getPosition();
+				const sf::Vector2f dimensions = trigger->getDimensions();
+				world.shapes.set(proxy, position, dimensions, trigger->shape);
+				world.broad_phase_tree.moveProxy(entry.leaf, shapeBounds(trigger->shape, position, dimensions));
+			}
+		}
+		if (!world.moved_proxies.empty())
+		{
+			world.pairs_stale = world.pairs_stale || !world.broad_phase_dirty;
+			world.moved_proxies.clear();
+		}
+	}
+
+	bool Trigger::acceptQueryHit(const trigger_world &world, const int proxy, const std::uint32_t mask,
+	                             std::shared_ptr<Trigger> &trigger)
+	{
+		if ((world.proxy_entries[proxy].category & mask) == 0)
+		{
+			return false;
+		}
+		trigger = world.proxy_entries[proxy].trigger.lock();
+		return trigger && trigger->active;
+	}
+
+	std::size_t Trigger::queryShape(trigger_world &world, const ShapeType shape, const sf::Vector2f position,
+	                                const sf::Vector2f dimensions, std::vector<std::shared_ptr<Trigger>> &result,
+	                                const std::uint32_t mask)
+	{
+		prepareQueries(world);
+		const shape_buffer &shapes = world.shapes;
+		result.clear();
+		const auto test = [&](const int proxy) {
+			std::shared_ptr<Trigger> trigger;
+			if (shapesCheck(shape, position, dimensions, static_cast<ShapeType>(shapes.shape[proxy]),
+			                {shapes.x[proxy], shapes.y[proxy]}, {shapes.width[proxy], shapes.height[proxy]}) &&
+			    acceptQueryHit(world, proxy, mask, trigger))
+			{
+				result.push_back(std::move(trigger));
+			}
+		};
+		const sf::FloatRect bounds = shapeBounds(shape, position, dimensions);
+		world.broad_phase_tree.query(bounds, [&](const int leaf) { test(world.leaf_proxies[leaf]); });
+		world.static_tree.query(bounds, test);
+		sortByOrder(result);
+		return result.size();
+	}
+
+	std::size_t Trigger::queryPoint(trigger_world &world, const sf::Vector2f point,
+	                                std::vector<std::shared_ptr<Trigger>> &result, const std::uint32_t mask)
+	{
+		prepareQueries(world);
+		const shape_buffer &shapes = world.shapes;
+		result.clear();
+		const auto test = [&](const int proxy) {
+			std::shared_ptr<Trigger> trigger;
+			if (pointToShapeCheck(point, static_cast<ShapeType>(shapes.shape[proxy]),
+			                      {shapes.x[proxy], shapes.y[proxy]}, {shapes.width[proxy], shapes.height[proxy]}) &&
+			    acceptQueryHit(world, proxy, mask, trigger))
+			{
+				result.push_back(std::move(trigger));
+			}
+		};
+		const sf::FloatRect bounds(point, {0, 0});
+		world.broad_phase_tree.query(bounds, [&](const int leaf) { test(world.leaf_proxies[leaf]); });
+		world.static_tree.query(bounds, test);
+		sortByOrder(result);
+		return result.size();
+	}
+
+	std::size_t Trigger::raycast(trigger_world &world, const sf::Vector2f origin, sf::Vector2f direction,
+	                             const float max_distance, const bool first_only, std::vector<raycast_hit> &hits,
+	                             const std::uint32_t mask)
+	{
+		hits.clear();
+		const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+		if (length == 0 || !(max_distance >= 0))
+		{
+			return 0;
+		}
+		direction /= length;
+		prepareQueries(world);
+		const shape_buffer &shapes = world.shapes;
+
+		// When only the first hit is needed the ray is shortened on every hit, skipping everything behind it
+		float ray_length = max_distance;
+		const auto test = [&](const int proxy) {
+			float distance;
+			std::shared_ptr<Trigger> trigger;
+			if (rayToShapeCheck(origin, direction, ray_length, static_cast<ShapeType>(shapes.shape[proxy]),
+			                    {shapes.x[proxy], shapes.y[proxy]}, {shapes.width[proxy], shapes.height[proxy]},
+			                    distance) &&
+			    acceptQueryHit(world, proxy, mask, trigger))
+			{
+				raycast_hit hit{std::move(trigger), distance, origin + direction * distance};
+				if (!first_only)
+				{
+					hits.push_back(std::move(hit));
+				}
+				else if (hits.empty())
+				{
+					hits.push_back(std::move(hit));
+					ray_length = distance;
+				}
+				else if (distance < hits.front().distance ||
+				         (distance == hits.front().distance && hit.trigger->order < hits.front().trigger->order))
+				{
+					hits.front() = std::move(hit);
+					ray_length = distance;
+				}
+			}
+			return ray_length;
+		};
+		world.broad_phase_tree.raycast(origin, direction, max_distance,
+		                               [&](const int leaf) { return test(world.leaf_proxies[leaf]); });
+		world.static_tree.raycast(origin, direction, ray_length, test);
+
+		std::sort(hits.begin(), hits.end(), [](const raycast_hit &a, const raycast_hit &b) {
+			return a.distance != b.distance ? a.distance < b.distance : a.trigger->order < b.trigger->order;
+		});
+		return hits.size();
+	}
+
+	void Trigger::sortByOrder(std::vector<std::shared_ptr<Trigger>> &triggers)
+	{
+		const auto by_order = [](const std::shared_ptr<Trigger> &a, const std::shared_ptr<Trigger> &b) {
+			return a->order < b->order;
+		};
+		std::sort(triggers.begin(), triggers.end(), by_order);
+	}
+
+	sf::FloatRect Trigger::proxyBounds(const trigger_world &world, const int proxy)
+	{
+		const shape_buffer &shapes = world.shapes;
+		return shapeBounds(static_cast<ShapeType>(shapes.shape[proxy]), {shapes.x[proxy], shapes.y[proxy]},
+		                   {shapes.width[proxy], shapes.height[proxy]});
+	}
+
+	void Trigger::buildStaticIndex(trigger_world &world)
+	{
+		std::vector<StaticTree::item> items;
+		for (const int proxy : world.subscribed)
+		{
+			if (proxy < 0 || !world.proxy_entries[proxy].is_static)
+			{
+				continue;
+			}
+			const auto trigger = world.proxy_entries[proxy].trigger.lock();
+
+			const sf::Vector2f position = trigger->getPosition();
+			const sf::Vector2f dimensions = trigger->getDimensions();
+			world.shapes.set(proxy, position, dimensions, trigger->shape);
+			world.proxy_entries[proxy].category = trigger->category;
+			world.proxy_entries[proxy].collision_mask = trigger->collision_mask;
+			items.push_back({shapeBounds(trigger->shape, position, dimensions), proxy});
+		}
+		world.static_tree.build(std::move(items));
+		world.static_dirty = false;
+	}
+
+	void Trigger::insertDynamicProxy(trigger_world &world, const int proxy, const sf::FloatRect &bounds)
+	{
+		const int leaf = world.broad_phase_tree.createProxy(bounds);
+		if (world.leaf_proxies.size() <= static_cast<std::size_t>(leaf))
+		{
+			world.leaf_proxies.resize(leaf + 1);
+		}
+		world.leaf_proxies[leaf] = proxy;
+		world.proxy_entries[proxy].leaf = leaf;
+		world.sweep_and_prune.insert(proxy, bounds);
+	}
+
+	void Trigger::removeDynamicProxy(trigger_world &world, const int proxy)
+	{
+		world.broad_phase_tree.destroyProxy(world.proxy_entries[proxy].leaf);
+		world.proxy_entries[proxy].leaf = DynamicTree::null_node;
+		world.sweep_and_prune.remove(proxy);
+	}
+
+	void Trigger::addProxyPair(trigger_world &world, const int proxy_a, const int proxy_b)
+	{
+		const trigger_world::proxy_entry &entry_a = world.proxy_entries[proxy_a];
+		const trigger_world::proxy_entry &entry_b = world.proxy_entries[proxy_b];
+		if ((entry_a.category & entry_b.collision_mask) != 0 && (entry_b.category & entry_a.collision_mask) != 0)
+		{
+			if (entry_a.order < entry_b.order)
+			{
+				world.proxy_pairs_buffer.emplace_back(proxy_a, proxy_b);
+			}
+			else
+			{
+				world.proxy_pairs_buffer.emplace_back(proxy_b, proxy_a);
+			}
+		}
+	}
+
+	void Trigger::groupPairs(trigger_world &world, const std::vector<std::pair<int, int>> &pairs, const bool symmetric,
+	                         std::vector<int> &grouped, std::vector<unsigned int> &offsets)
+	{
+		// Counting sort of the pairs by proxy
+		offsets.assign(world.proxy_entries.size() + 1, 0);
+		for (const auto &[proxy_a, proxy_b] : pairs)
+		{
+			++offsets[proxy_a + 1];
+			if (symmetric)
+			{
+				++offsets[proxy_b + 1];
+			}
+		}
+		for (std::size_t i = 1; i < offsets.size(); ++i)
+		{
+			offsets[i] += offsets[i - 1];
+		}
+
+		grouped.resize(offsets.back());
+		world.broad_phase_candidates.assign(offsets.begin(), offsets.end() - 1);
+		for (const auto &[proxy_a, proxy_b] : pairs)
+		{
+			grouped[world.broad_phase_candidates[proxy_a]++] = proxy_b;
+			if (symmetric)
+			{
+				grouped[world.broad_phase_candidates[proxy_b]++] = proxy_a;
+			}
+		}
+
+		if (symmetric)
+		{
+			// Same order as in runBruteForceChecks
+			for (std::size_t proxy = 0; proxy + 1 < offsets.size(); ++proxy)
+			{
+				std::sort(grouped.begin() + offsets[proxy], grouped.begin() + offsets[proxy + 1],
+				          [&world](const int a, const int b) {
+					          return world.proxy_entries[a].order < world.proxy_entries[b].order;
+				          });
+			}
+		}
+	}
+
+	void Trigger::runNarrowPhase(trigger_world &world)
+	{
+		world.narrow_phase_pool.resize(world.settings.worker_threads);
+		world.narrow_phase_buffers.resize(world.narrow_phase_pool.size());
+
+		// Parallel phase, every participant takes chunks of proxies and only writes on its own buffer
+		constexpr std::size_t chunk_size = 64;
+		const std::size_t proxies_count = world.proxy_pairs_offsets.size() - 1;
+		std::atomic<std::size_t> next_chunk = 0;
+		world.narrow_phase_pool.run([&](const unsigned int participant) {
+			trigger_world::narrow_phase_buffer &buffer = world.narrow_phase_buffers[participant];
+			buffer.contacts.clear();
+			for (std::size_t begin = next_chunk.fetch_add(chunk_size); begin < proxies_count;
+			     begin = next_chunk.fetch_add(chunk_size))
+			{
+				const std::size_t end = std::min(begin + chunk_size, proxies_count);
+				for (std::size_t proxy = begin; proxy < end; ++proxy)
+				{
+					// A pair can't fire if one of its Triggers already made its checks
+					if (world.proxy_checked[proxy])
+					{
+						continue;
+					}
+					buffer.candidates.clear();
+					const unsigned int end = world.proxy_pairs_offsets[proxy + 1];
+					for (unsigned int i = world.proxy_pairs_offsets[proxy]; i < end; ++i)
+					{
+						if (!world.proxy_checked[world.proxy_pairs[i]])
+						{
+							buffer.candidates.push_back(world.proxy_pairs[i]);
+						}
+					}
+					buffer.hits.resize(buffer.candidates.size());
+					const std::size_t hits_count = shapesBatchCheck(world.shapes, static_cast<int>(proxy),
+					                                                buffer.candidates.data(), buffer.candidates.size(),
+					                                                buffer.hits.data());
+					for (std::size_t i = 0; i < hits_count; ++i)
+					{
+						buffer.contacts.emplace_back(static_cast<int>(proxy), buffer.hits[i]);
+					}
+				}
+			}
+		});
+
+		// Merge, sorting by subscription order makes the result independent of how the work was split
+		world.contact_pairs_buffer.clear();
+		for (const trigger_world::narrow_phase_buffer &buffer : world.narrow_phase_buffers)
+		{
+			world.contact_pairs_buffer.insert(world.contact_pairs_buffer.end(), buffer.contacts.begin(),
+			                                  buffer.contacts.end());
+		}
+		groupPairs(world, world.contact_pairs_buffer, true, world.contact_pairs, world.contact_pairs_offsets);
+	}
+
+	void Trigger::removeProxy(trigger_world &world, const int proxy)
+	{
+		trigger_world::proxy_entry &removed = world.proxy_entries[proxy];
+		if (removed.is_static)
+		{
+			world.static_dirty = true;
+		}
+		else
+		{
+			removeDynamicProxy(world, proxy);
+		}
+		world.subscribed[removed.slot] = -1;
+		removed.trigger.reset();
+		removed.moved = false;
+		++removed.generation;
+		world.released_proxies.push_back(proxy);
+		world.broad_phase_dirty = true;
+		world.query_tree_dirty = true;
+	}
+
+	std::shared_ptr<Trigger> Trigger::findTrigger(const trigger_world &world, const trigger_handle handle)
+	{
+		if (handle.proxy < 0 || handle.proxy >= static_cast<int>(world.proxy_entries.size()) ||
+		    world.proxy_entries[handle.proxy].generation != handle.generation)
+		{
+			return nullptr;
+		}
+		return world.proxy_entries[handle.proxy].trigger.lock();
+	}
+
+	std::shared_ptr<trigger_world> Trigger::findWorld() const
+	{
+		if (const auto room = getRoom())
+		{
+			return room->getTriggerWorld();
+		}
+		return detached_world;
+	}
+
+	std::shared_ptr<Room> Trigger::getRoom() const
+	{
+		LocalCoords *root = getParentCoords();
+		if (!root)
+		{
+			return nullptr;
+		}
+		while (LocalCoords *parent = root->getParentCoords())
+		{
+			root = parent;
+		}
+
+		// Only the root is locked, the hierarchy is walked through handles
+		if (auto *room = dynamic_cast<Room *>(root))
+		{
+			return std::static_pointer_cast<Room>(room->weak_from_this().lock());
+		}
+		return nullptr;
 	}
 
 	void Trigger::subscribe()
 	{
 		if (!active) {
+			const auto current = findWorld();
+			if (world.lock() != current)
+			{
+				// Frames of another world
+				checked_frame = no_frame;
+			}
+			world = current;
 			active = true;
-			active_triggers.push_back(shared_from_this());
+			int proxy;
+			if (current->free_proxies.empty())
+			{
+				proxy = static_cast<int>(current->proxy_entries.size());
+				current->proxy_entries.emplace_back();
+			}
+			else
+			{
+				proxy = current->free_proxies.back();
+				current->free_proxies.pop_back();
+			}
+			order = current->subscriptions_count++;
+			trigger_world::proxy_entry &entry = current->proxy_entries[proxy];
+			entry.trigger = shared_from_this();
+			entry.slot = static_cast<int>(current->subscribed.size());
+			entry.is_static = is_static;
+			entry.leaf = DynamicTree::null_node;
+			entry.order = order;
+			entry.category = category;
+			entry.collision_mask = collision_mask;
+			if (is_static)
+			{
+				current->static_dirty = true;
+			}
+			else
+			{
+				insertDynamicProxy(*current, proxy, getBounds());
+			}
+			current->subscribed.push_back(proxy);
+			current->broad_phase_dirty = true;
+			current->query_tree_dirty = true;
+			handle = {proxy, entry.generation};
 		}
 	}
 
@@ -78,12 +736,24 @@ namespace mate
 		if (active)
 		{
 			active = false;
-			active_triggers.remove_if([this](const std::weak_ptr<Trigger>& wp) {
-				if (const auto sp = wp.lock()) {
-					return sp == shared_from_this();
-				}
-				return false;
-			});
+			if (const auto current = world.lock())
+			{
+				removeProxy(*current, handle.proxy);
+			}
+		}
+	}
+
+	void Trigger::onSleep()
+	{
+		active_before_sleep = active;
+		unsubscribe();
+	}
+
+	void Trigger::onWake()
+	{
+		if (active_before_sleep)
+		{
+			subscribe();
 		}
 	}
 
@@ -96,39 +766,130 @@ namespace mate
 
 	void Trigger::loop()
 	{
-		if (active)
+		if (const auto current = world.lock())
 		{
-			runChecks();
+			current->contacts_frame_ended = false;
+			if (active)
+			{
+				runChecks(*current);
+			}
 		}
 	}
 
 	void Trigger::renderLoop()
 	{
-		checked = false;
+		if (const auto current = world.lock(); current && !current->room_owned)
+		{
+			current->broad_phase_dirty = true;
+			current->query_tree_dirty = true;
+			if (!current->contacts_frame_ended)
+			{
+				endContactsFrame(*current);
+			}
+		}
+	}
+
+	void Trigger::endTick(trigger_world &world)
+	{
+		world.broad_phase_dirty = true;
+		world.query_tree_dirty = true;
+		// Contacts left by Triggers destroyed or purged without any other Trigger looping still end
+		if (!world.contacts_frame_ended || world.contacts.size() > 0)
+		{
+			endContactsFrame(world);
+		}
 	}
 
 	sf::Vector2f Trigger::getPosition() const
 	{
-		if (const auto spt_parent = _parent.lock())
+		if (LocalCoords *parent = getParentCoords())
 		{
-			return offset.getPositionBounds(spt_parent->getWorldPosition());
+			return offset.getPositionBounds(parent->getWorldPosition());
 		}
 		return {0, 0};
 	}
 
 	sf::Vector2f Trigger::getDimensions() const
 	{
-		if (const auto spt_parent = _parent.lock())
+		if (LocalCoords *parent = getParentCoords())
 		{
-			return offset.getDimensionBounds(spt_parent->getWorldScale());
+			return offset.getDimensionBounds(parent->getWorldScale());
 		}
 		return {0, 0};
 	}
 
+	sf::FloatRect Trigger::getBounds() const
+	{
+		return shapeBounds(shape, getPosition(), getDimensions());
+	}
+
+	sf::FloatRect Trigger::shapeBounds(const ShapeType shape, const sf::Vector2f position,
+	                                   const sf::Vector2f dimensions)
+	{
+		if (shape == CIRCLE)
+		{
+			// Same center and radius used by the circle checks
+			const float radius = std::max(dimensions.x, dimensions.y) / 2;
+			const float extent = std::abs(radius);
+			return {position.x + radius - extent, position.y + radius - extent, 2 * extent, 2 * extent};
+		}
+		return {std::min(position.x, position.x + dimensions.x), std::min(position.y, position.y + dimensions.y),
+		        std::abs(dimensions.x), std::abs(dimensions.y)};
+	}
+
+	void Trigger::setStatic(const bool is_static)
+	{
+		if (this->is_static == is_static)
+		{
+			return;
+		}
+		this->is_static = is_static;
+		const auto current = world.lock();
+		if (active && current)
+		{
+			const int proxy = handle.proxy;
+			current->proxy_entries[proxy].is_static = is_static;
+			if (is_static)
+			{
+				removeDynamicProxy(*current, proxy);
+			}
+			else
+			{
+				insertDynamicProxy(*current, proxy, getBounds());
+			}
+			current->static_dirty = true;
+			current->broad_phase_dirty = true;
+			current->query_tree_dirty = true;
+		}
+	}
+
+	void Trigger::setCategory(const std::uint32_t category)
+	{
+		this->category = category;
+		if (const auto current = world.lock(); active && current)
+		{
+			current->broad_phase_dirty = true;
+			current->query_tree_dirty = true;
+			current->static_dirty = current->static_dirty || is_static;
+		}
+	}
+
+	void Trigger::setCollisionMask(const std::uint32_t collision_mask)
+	{
+		this->collision_mask = collision_mask;
+		if (const auto current = world.lock(); active && current)
+		{
+			current->broad_phase_dirty = true;
+			current->query_tree_dirty = true;
+			current->static_dirty = current->static_dirty || is_static;
+		}
+	}
+
 	void Trigger::setDimensions(const float width, const float height)
 	{
 		offset.rect_bounds.width = width;
 		offset.rect_bounds.height = height;
+		boundsChanged();
 	}
 
 
@@ -136,111 +897,77 @@ namespace mate
 	{
 		offset.rect_bounds.left = x;
 		offset.rect_bounds.top = y;
+		boundsChanged();
 	}
 
 	// Todo: Rotated rectangles
 	// Todo: Add depth to triggers
-	void Trigger::checkTrigger(const std::shared_ptr<Trigger>& trigger_a, const std::shared_ptr<Trigger>& trigger_b)
+	void Trigger::checkTrigger(trigger_world &world, const std::shared_ptr<Trigger>& trigger_a,
+	                           const std::shared_ptr<Trigger>& trigger_b)
 	{
-		const sf::Vector2f position_a = trigger_a->getPosition();
-		const sf::Vector2f dimensions_a = trigger_a->getDimensions();
-
-		const sf::Vector2 position_b = trigger_b->getPosition();
-		const sf::Vector2 dimensions_b = trigger_b->getDimensions();
-
-		bool collide = false;
-		switch (trigger_a->getShape())
-	        {
-	        case RECTANGLE:
-	            switch (trigger_b->getShape())
-	            {
-	            case RECTANGLE:
-	                // Collision between two rectangles
-	                collide = rectangleToRectangleCheck(position_a, dimensions_a, position_b, dimensions_b);
-	                break;
-	            case CIRCLE:
-	                // B is a circle, A is a rectangle
-	            	collide = circleToRectangleCheck(position_b, dimensions_b, position_a, dimensions_a);
-	                break;
-	            }
-	            break;
-	        case CIRCLE:
-	            switch (trigger_b->getShape())
-	            {
-	            case RECTANGLE:
-	            	// A is a circle, B is a rectangle
-	            	collide = circleToRectangleCheck(position_a, dimensions_a, position_b, dimensions_b);
-	                break;
-	            case CIRCLE:
-	                // Collision between circles
-	                collide = circleToCircleCheck(position_a, dimensions_a, position_b, dimensions_b);
-	                break;
-	            }
-	            break;
-	        }
-
-		if (collide){
-			trigger_b->fireTrigger(trigger_a);
-			trigger_a->fireTrigger(trigger_b);
+		if (!(trigger_a->is_static && trigger_b->is_static) && trigger_a->canCollideWith(*trigger_b) &&
+		    shapesCheck(trigger_a->getShape(), trigger_a->getPosition(), trigger_a->getDimensions(),
+		                trigger_b->getShape(), trigger_b->getPosition(), trigger_b->getDimensions()))
+		{
+			fireContact(world, trigger_a, trigger_b);
 		}
 	}
 
-	bool rectangleToRectangleCheck(const sf::Vector2f rect1_pos, const sf::Vector2f rect1_dim, const sf::Vector2f rect2_pos, const sf::Vector2f rect2_dim)
+	void Trigger::fireContact(trigger_world &world, const std::shared_ptr<Trigger>& trigger_a,
+	                          const std::shared_ptr<Trigger>& trigger_b)
 	{
-		return rect1_pos.x + rect1_dim.x > rect2_pos.x && rect1_pos.x < rect2_pos.x + rect2_dim.x &&
-		       rect1_pos.y < rect2_pos.y + rect2_dim.y && rect1_pos.y + rect1_dim.y > rect2_pos.y;
-	}
+		trigger_b->fireTrigger(trigger_a);
+		trigger_a->fireTrigger(trigger_b);
 
-	bool circleToCircleCheck(sf::Vector2f circ1_pos, const sf::Vector2f circ1_dim, sf::Vector2f circ2_pos, const sf::Vector2f circ2_dim)
-	{
-		const float circ1_rad = std::max(circ1_dim.x, circ1_dim.y) / 2;
-		circ1_pos.x += circ1_rad;
-		circ1_pos.y += circ1_rad;
-
-		const float circ2_rad = std::max(circ2_dim.x, circ2_dim.y) / 2;
-		circ2_pos.x += circ2_rad;
-		circ2_pos.y += circ2_rad;
-
-		const double distance = std::sqrt(std::pow(circ1_pos.x - circ2_pos.x, 2) + std::pow(circ1_pos.y - circ2_pos.y, 2));
-		return circ1_rad + circ2_rad > distance;
+		auto [pair, inserted] = world.contacts.tryEmplace(trigger_a->order, trigger_b->order);
+		pair->frame = world.contacts_frame;
+		if (inserted)
+		{
+			pair->first = trigger_a->order < trigger_b->order ? trigger_a : trigger_b;
+			pair->second = trigger_a->order < trigger_b->order ? trigger_b : trigger_a;
+			trigger_b->onEnter(trigger_a);
+			trigger_a->onEnter(trigger_b);
+		}
+		else
+		{
+			trigger_b->onStay(trigger_a);
+			trigger_a->onStay(trigger_b);
+		}
 	}
 
-
-	bool circleToRectangleCheck(sf::Vector2f circ_pos, const sf::Vector2f circ_dim, const sf::Vector2f rect_pos, const sf::Vector2f rect_dim)
+	void Trigger::endContactsFrame(trigger_world &world)
 	{
-		// Use the center of the circle instead of the corner, also stores the radius
-		const float radius = std::max(circ_dim.x, circ_dim.y) / 2;
-		circ_pos.x += radius;
-		circ_pos.y += radius;
-
-		double distance_x = rect_pos.x + rect_dim.x / 2 - circ_pos.x;
-		short sign = std::signbit(distance_x);
-		// If distance_x is positive means circle is on the left, negative means it's on the right
-		// Checks if the circle is inside the rectangle using it's nearest horizontal sides
-		if (circ_pos.x + ((distance_x >= 0) - (distance_x < 0)) * radius >= rect_pos.x + sign * rect_dim.x != sign &&
-			circ_pos.y <= rect_pos.y + rect_dim.y && circ_pos.y >= rect_pos.y)
+		world.ended_contacts.clear();
+		world.contacts.forEach([&world](const std::uint64_t first, const std::uint64_t second,
+		                                const trigger_world::contact &pair) {
+			if (pair.frame != world.contacts_frame)
+			{
+				world.ended_contacts.push_back({first, second, pair, true});
+			}
+		});
+		for (const auto &ended : world.ended_contacts)
 		{
-			return true;
+			world.contacts.erase(ended.first, ended.second);
 		}
-
-		double distance_y = rect_pos.y + rect_dim.y / 2 - circ_pos.y;
-		sign = std::signbit(distance_y);
-		// If distance_y is positive means circle is above, negative means it's below
-		// Same as before but using the vertical sides
-		if (circ_pos.y + ((distance_y >= 0) - (distance_y < 0)) * radius >= rect_pos.y + sign * rect_dim.y != sign &&
-			circ_pos.x <= rect_pos.x + rect_dim.x && circ_pos.x >= rect_pos.x)
+		++world.contacts_frame;
+		world.contacts_frame_ended = true;
+
+		// The map order depends on the hash, sorting keeps the events in subscription order
+		std::sort(world.ended_contacts.begin(), world.ended_contacts.end(), [](const auto &a, const auto &b) {
+			return a.first != b.first ? a.first < b.first : a.second < b.second;
+		});
+		for (const auto &ended : world.ended_contacts)
 		{
-			return true;
+			const auto first = ended.value.first.lock();
+			const auto second = ended.value.second.lock();
+			if (second)
+			{
+				second->onExit(first);
+			}
+			if (first)
+			{
+				first->onExit(second);
+			}
 		}
-
-		// Finally checks if the nearest corner of the rectangle is inside the circle
-		//  (Which can happen even when both the previous conditions are false)
-		// This is checked last to reduce the use of the sqrt function
-		distance_x += ((distance_x < 0) - (distance_x >= 0)) * rect_dim.x / 2;
-		distance_y += ((distance_y < 0) - (distance_y >= 0)) * rect_dim.y / 2;
-
-		const double distance = std::sqrt(std::pow(distance_y, 2) + std::pow(distance_x, 2));
-		return distance < radius;
 	}
-
 } // namespace mate
@@ -0,0 +1,102 @@
+/**
+ * @brief WorkerPool class methods definitions
+ * @file WorkerPool.cpp
+ */
+
+#include "WorkerPool.h"
+#include <algorithm>
+
+namespace mate
+{
+WorkerPool::WorkerPool(const unsigned int participants)
+{
+    resize(participants);
+}
+
+WorkerPool::~WorkerPool()
+{
+    stop();
+}
+
+void WorkerPool::resize(unsigned int participants)
+{
+    if (participants == 0)
+    {
+        participants = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    if (participants == size())
+    {
+        return;
+    }
+
+    stop();
+    _stop = false;
+    for (unsigned int participant = 1; participant < participants; ++participant)
+    {
+        _threads.emplace_back(&WorkerPool::work, this, participant, _generation);
+    }
+}
+
+void WorkerPool::run(const std::function<void(unsigned int)> &task)
+{
+    if (_threads.empty())
+    {
+        task(0);
+        return;
+    }
+
+    {
+        std::lock_guard lock(_mutex);
+        _task = &task;
+        _pending = static_cast<unsigned int>(_threads.size());
+        ++_generation;
+    }
+    _start.notify_all();
+
+    task(0);
+
+    std::unique_lock lock(_mutex);
+    _done.wait(lock, [this]() { return _pending == 0; });
+    _task = nullptr;
+}
+
+void WorkerPool::work(const unsigned int participant, unsigned long generation)
+{
+    while (true)
+    {
+        const std::function<void(unsigned int)> *task;
+        {
+            std::unique_lock lock(_mutex);
+            _start.wait(lock, [&]() { return _stop || _generation != generation; });
+            if (_stop)
+            {
+                return;
+            }
+            generation = _generation;
+            task = _task;
+        }
+
+        (*task)(participant);
+
+        {
+            std::lock_guard lock(_mutex);
+            --_pending;
+        }
+        _done.notify_one();
+    }
+}
+
+void WorkerPool::stop()
+{
+    {
+        std::lock_guard lock(_mutex);
+        _stop = true;
+    }
+    _start.notify_all();
+    for (auto &thread : _threads)
+    {
+        thread.join();
+    }
+    _threads.clear();
+}
+} // namespace mate
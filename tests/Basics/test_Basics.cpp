@@ -1,6 +1,89 @@
 #include "GDMBasics.h"
 #include <gtest/gtest.h>
+#include <atomic>
 #include <cmath>
+#include <thread>
+
+namespace
+{
+// Counts the calls of every phase
+class PhaseCounter : public mate::Component
+{
+  public:
+    explicit PhaseCounter(const std::weak_ptr<mate::Element> &parent) : Component(parent)
+    {
+    }
+    void loop() override
+    {
+        ++loops;
+    }
+    void renderLoop() override
+    {
+        ++render_loops;
+    }
+    void windowResizeEvent() override
+    {
+        ++resize_events;
+    }
+    int loops = 0;
+    int render_loops = 0;
+    int resize_events = 0;
+};
+
+class LoopOnly : public mate::Component
+{
+  public:
+    explicit LoopOnly(const std::weak_ptr<mate::Element> &parent) : Component(parent)
+    {
+    }
+    void loop() override
+    {
+    }
+};
+
+// Counts its loops from any thread, destroys its Element after a few
+class ThreadedCounter : public mate::Component
+{
+  public:
+    static constexpr mate::ThreadAffinity thread_affinity = mate::ANY_THREAD;
+
+    explicit ThreadedCounter(const std::weak_ptr<mate::Element> &parent) : Component(parent)
+    {
+    }
+    void loop() override
+    {
+        ++loops;
+        if (loops == lifetime)
+        {
+            if (only_itself)
+            {
+                destroy();
+            }
+            else if (auto *element = static_cast<mate::Element *>(getParentCoords()))
+            {
+                element->destroy();
+            }
+        }
+    }
+    int loops = 0;
+    int lifetime = -1;
+    bool only_itself = false; ///< Destroys the Component instead of its Element.
+};
+
+// Records the thread it loops on
+class MainThreadProbe : public mate::Component
+{
+  public:
+    explicit MainThreadProbe(const std::weak_ptr<mate::Element> &parent) : Component(parent)
+    {
+    }
+    void loop() override
+    {
+        thread = std::this_thread::get_id();
+    }
+    std::thread::id thread;
+};
+} // namespace
 
 // Game creation tests
 
@@ -268,3 +351,719 @@ TEST(BasicsTest, WeakPointerIsUninitialized){
     EXPECT_EQ(mate::weakPtrIsUninitialized(element), false);
 }
 
+
+TEST(BasicsTest, CachedWorldCoords)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    auto child = element->addChild();
+    auto grandchild = child->addChild();
+    child->setPosition(1, 1);
+    grandchild->setPosition(1, 1);
+
+    EXPECT_EQ(grandchild->getWorldPosition(), sf::Vector2f(2, 2));
+    // Changes on any ancestor reach the cached values
+    room->move(10, 0);
+    EXPECT_EQ(grandchild->getWorldPosition(), sf::Vector2f(12, 2));
+    element->setScale(2, 3);
+    EXPECT_EQ(grandchild->getWorldScale(), sf::Vector2f(2, 3));
+    EXPECT_EQ(child->getWorldScale(), sf::Vector2f(2, 3));
+    child->rotate(20);
+    EXPECT_EQ(grandchild->getWorldRotation(), 20);
+
+    // Changing parent
+    auto other = room->addElement();
+    other->setPosition(100, 100);
+    child->setRotation(0);
+    child->setParent(other);
+    EXPECT_EQ(grandchild->getWorldPosition(), sf::Vector2f(112, 102));
+    EXPECT_EQ(grandchild->getWorldScale(), sf::Vector2f(1, 1));
+    element.reset();
+    other->setPosition(0, 0);
+    EXPECT_EQ(grandchild->getWorldPosition(), sf::Vector2f(12, 2));
+
+    // Orphans fall back to their local coordinates
+    auto orphan = std::make_shared<mate::Element>(child, sf::Vector2f(5, 5));
+    EXPECT_EQ(orphan->getWorldPosition(), sf::Vector2f(16, 6));
+    child->setParent(std::weak_ptr<mate::LocalCoords>());
+    EXPECT_EQ(orphan->getWorldPosition(), sf::Vector2f(6, 6));
+
+    // A deep hierarchy, the scale used to be exponential on the depth
+    std::vector<std::shared_ptr<mate::Element>> chain{room->addElement()};
+    for (int i = 0; i < 200; ++i)
+    {
+        chain.push_back(chain.back()->addChild());
+        chain.back()->setPosition(1, 0);
+        chain.back()->setScale(1, 1);
+    }
+    chain.front()->setPosition(0, 0);
+    chain.front()->setScale(2, 2);
+    EXPECT_EQ(chain.back()->getWorldScale(), sf::Vector2f(2, 2));
+    EXPECT_EQ(chain.back()->getWorldPosition(), sf::Vector2f(410, 0));
+}
+
+TEST(BasicsTest, WorldTransform)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    auto child = element->addChild();
+    element->setPosition(10, 20);
+    element->setScale(2, 3);
+    child->setPosition(1, 1);
+
+    // The parent's scale applies to the child's position
+    EXPECT_EQ(child->getWorldPosition(), sf::Vector2f(12, 23));
+    EXPECT_EQ(child->getWorldTransform().transformPoint(1, 0), sf::Vector2f(14, 23));
+
+    // And so does the rotation, 90 degrees turn +x into +y
+    element->setScale(1, 1);
+    element->setRotation(90);
+    EXPECT_NEAR(child->getWorldPosition().x, 9, 1e-5);
+    EXPECT_NEAR(child->getWorldPosition().y, 21, 1e-5);
+    EXPECT_EQ(child->getWorldRotation(), 90);
+
+    // The matrix is the composition of the local ones
+    const sf::Transform expected = room->getTransform() * element->getTransform() * child->getTransform();
+    const sf::Vector2f point = child->getWorldTransform().transformPoint(3, -4);
+    EXPECT_NEAR(point.x, expected.transformPoint(3, -4).x, 1e-5);
+    EXPECT_NEAR(point.y, expected.transformPoint(3, -4).y, 1e-5);
+
+    element->setOrigin(1, 1);
+    element->setRotation(0);
+    EXPECT_EQ(child->getWorldPosition(), sf::Vector2f(10, 20));
+}
+
+TEST(BasicsTest, TransformStore)
+{
+    // Same hierarchy with and without a store
+    auto room = std::make_shared<mate::Room>();
+    auto stored_room = std::make_shared<mate::Room>();
+    auto store = std::make_shared<mate::TransformStore>();
+    stored_room->useTransformStore(store);
+    std::vector<std::shared_ptr<mate::Element>> elements;
+    std::vector<std::shared_ptr<mate::Element>> stored_elements;
+    for (int i = 0; i < 30; ++i)
+    {
+        // Every element is a child of the element 2/3 of the way back, or a top Element
+        const int parent = i * 2 / 3;
+        elements.push_back(i % 5 == 0 ? room->addElement() : elements[parent]->addChild());
+        stored_elements.push_back(i % 5 == 0 ? stored_room->addElement() : stored_elements[parent]->addChild());
+    }
+    EXPECT_EQ(store->size(), 31);
+
+    auto expectSame = [&]() {
+        for (std::size_t i = 0; i < elements.size(); ++i)
+        {
+            if (!elements[i])
+            {
+                continue;
+            }
+            EXPECT_EQ(stored_elements[i]->getTransformStore(), store);
+            EXPECT_NEAR(stored_elements[i]->getWorldPosition().x, elements[i]->getWorldPosition().x, 1e-3);
+            EXPECT_NEAR(stored_elements[i]->getWorldPosition().y, elements[i]->getWorldPosition().y, 1e-3);
+            EXPECT_NEAR(stored_elements[i]->getWorldScale().x, elements[i]->getWorldScale().x, 1e-5);
+            EXPECT_NEAR(stored_elements[i]->getWorldRotation(), elements[i]->getWorldRotation(), 1e-3);
+        }
+    };
+    auto moveAll = [&](float step) {
+        for (std::size_t i = 0; i < elements.size(); ++i)
+        {
+            for (auto *element : {&elements[i], &stored_elements[i]})
+            {
+                if (*element)
+                {
+                    (*element)->move(step * static_cast<float>(i), 1);
+                    (*element)->rotate(step);
+                    (*element)->setScale(1 + static_cast<float>(i % 3) / 10, 1);
+                }
+            }
+        }
+    };
+    moveAll(1);
+    expectSame();
+    room->move(5, 5);
+    stored_room->move(5, 5);
+    expectSame();
+
+    // Moving a subtree below a node added later forces the store to reorder
+    elements[3]->setParent(elements[29]);
+    stored_elements[3]->setParent(stored_elements[29]);
+    moveAll(2);
+    expectSame();
+
+    // Removing nodes, the children still referenced become roots
+    elements[1]->destroy();
+    stored_elements[1]->destroy();
+    room->loop();
+    stored_room->loop();
+    elements[1].reset();
+    stored_elements[1].reset();
+    EXPECT_EQ(store->size(), 30);
+    elements[2] = elements[2]->addChild();
+    stored_elements[2] = stored_elements[2]->addChild();
+    moveAll(3);
+    expectSame();
+
+    // Leaving the store
+    auto outside = std::make_shared<mate::Element>();
+    stored_elements[10]->setParent(outside);
+    EXPECT_EQ(stored_elements[10]->getTransformStore(), nullptr);
+    EXPECT_EQ(stored_elements[16]->getTransformStore(), nullptr);
+    stored_elements[10]->setParent(stored_elements[5]);
+    EXPECT_EQ(stored_elements[16]->getTransformStore(), store);
+    stored_room->useTransformStore(nullptr);
+    EXPECT_EQ(stored_elements[0]->getTransformStore(), nullptr);
+    // The orphaned subtree is its own hierarchy
+    EXPECT_EQ(stored_elements[2]->getTransformStore(), store);
+    EXPECT_LT(store->size(), 30);
+    elements[10]->setParent(elements[5]);
+    for (std::size_t i = 0; i < elements.size(); ++i)
+    {
+        if (elements[i])
+        {
+            EXPECT_EQ(stored_elements[i]->getWorldPosition(), elements[i]->getWorldPosition());
+        }
+    }
+    stored_room->useTransformStore(store);
+    expectSame();
+
+    // Moving and reading one Element at a time, in the order of the store and out of it
+    for (const std::size_t step : {1, 7})
+    {
+        for (std::size_t i = 0; i < elements.size(); ++i)
+        {
+            const std::size_t index = i * step % elements.size();
+            if (!elements[index] || !stored_elements[index])
+            {
+                continue;
+            }
+            for (auto *element : {&elements[index], &stored_elements[index]})
+            {
+                (*element)->move(1, 2);
+                (*element)->rotate(3);
+            }
+            EXPECT_NEAR(stored_elements[index]->getWorldPosition().x, elements[index]->getWorldPosition().x, 1e-3);
+            EXPECT_NEAR(stored_elements[index]->getWorldPosition().y, elements[index]->getWorldPosition().y, 1e-3);
+        }
+        expectSame();
+    }
+}
+
+TEST(BasicsTest, ParallelTransformPropagation)
+{
+    auto room = std::make_shared<mate::Room>();
+    room->setTransformThreads(4);
+    room->setTransformParallelThreshold(0);
+    std::vector<std::shared_ptr<mate::Element>> elements;
+    for (int i = 0; i < 200; ++i)
+    {
+        elements.push_back(i % 10 == 0 ? room->addElement() : elements[i - 1 - (i % 10 > 1 ? i % 2 : 0)]->addChild());
+        elements.back()->setPosition(static_cast<float>(i % 7), static_cast<float>(i % 5));
+        elements.back()->setRotation(static_cast<float>(i % 11));
+    }
+
+    // The first propagation counts the objects, the next ones are split across threads
+    EXPECT_EQ(room->propagateTransforms(), 201);
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        room->move(3, 1);
+        room->rotate(5);
+        room->loop();
+        for (const auto &element : elements)
+        {
+            // Same as computing it on demand
+            sf::Transform expected = element->getTransform();
+            for (auto parent = element->getParent().lock(); parent; parent = parent->getParent().lock())
+            {
+                expected = parent->getTransform() * expected;
+            }
+            EXPECT_NEAR(element->getWorldPosition().x, expected.transformPoint(0, 0).x, 1e-3);
+            EXPECT_NEAR(element->getWorldPosition().y, expected.transformPoint(0, 0).y, 1e-3);
+        }
+    }
+
+    room->useTransformStore(std::make_shared<mate::TransformStore>());
+    EXPECT_EQ(room->propagateTransforms(), 201);
+}
+
+TEST(BasicsTest, GenerationalHandles)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    auto child = element->addChild();
+    EXPECT_EQ(mate::LocalCoords::fromHandle(element->getHandle()), element.get());
+    EXPECT_EQ(child->getParentCoords(), element.get());
+    EXPECT_EQ(element->getParentCoords(), room.get());
+    EXPECT_EQ(room->getParentCoords(), nullptr);
+    EXPECT_EQ(mate::LocalCoords::fromHandle(mate::object_handle()), nullptr);
+
+    auto sprite = element->addComponent<mate::Sprite>();
+    const mate::object_handle sprite_handle = sprite->getHandle();
+    EXPECT_EQ(mate::Component::fromHandle(sprite_handle), sprite.get());
+
+    // Destroyed objects fail their handles, even after their slot is reused
+    const mate::object_handle element_handle = element->getHandle();
+    element->destroy();
+    room->loop();
+    element.reset();
+    sprite.reset();
+    EXPECT_EQ(mate::LocalCoords::fromHandle(element_handle), nullptr);
+    EXPECT_EQ(mate::Component::fromHandle(sprite_handle), nullptr);
+    EXPECT_EQ(child->getParentCoords(), nullptr);
+    auto other = room->addElement();
+    auto other_sprite = other->addComponent<mate::Sprite>();
+    EXPECT_EQ(mate::LocalCoords::fromHandle(element_handle), nullptr);
+    EXPECT_EQ(mate::Component::fromHandle(sprite_handle), nullptr);
+    EXPECT_EQ(mate::LocalCoords::fromHandle(other->getHandle()), other.get());
+
+    child->setParent(other);
+    EXPECT_EQ(child->getParentCoords(), other.get());
+    child->setParent(std::weak_ptr<mate::LocalCoords>());
+    EXPECT_EQ(child->getParentCoords(), nullptr);
+}
+
+TEST(BasicsTest, ComponentStorage)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto before_element = room->addElement();
+    auto before = before_element->addComponent<mate::Sprite>();
+    EXPECT_EQ(room->getComponentStorage(), nullptr);
+
+    room->useComponentStorage();
+    mate::ComponentStorage *storage = room->getComponentStorage();
+    ASSERT_NE(storage, nullptr);
+
+    auto element = room->addElement();
+    auto sprite = element->addComponent<mate::Sprite>();
+    auto input = element->addComponent<mate::InputActions>();
+    auto trigger = element->addChild()->addComponent<mate::EmptyTrigger>();
+    EXPECT_EQ(storage->getTable<mate::Sprite>().size(), 1);
+    EXPECT_EQ(storage->getTable<mate::InputActions>().size(), 1);
+    EXPECT_EQ(storage->getTable<mate::EmptyTrigger>().size(), 1);
+
+    // The tables are run by the Room
+    element->setPosition(30, 40);
+    room->loop();
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().x, 30);
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().y, 40);
+    room->renderLoop();
+
+    // Destroyed Elements free their slots
+    element->destroy();
+    room->loop();
+    element.reset();
+    sprite.reset();
+    input.reset();
+    trigger.reset();
+    EXPECT_EQ(storage->getTable<mate::Sprite>().size(), 0);
+    EXPECT_EQ(storage->getTable<mate::InputActions>().size(), 0);
+    EXPECT_EQ(storage->getTable<mate::EmptyTrigger>().size(), 0);
+
+    auto reused = room->addElement()->addComponent<mate::Sprite>();
+    EXPECT_EQ(storage->getTable<mate::Sprite>().size(), 1);
+
+    // Components added before the storage are still run by their Element
+    EXPECT_EQ(storage->getTable<mate::Sprite>().size(), 1);
+    before_element->setPosition(5, 6);
+    room->loop();
+    EXPECT_FLOAT_EQ(before->getSprite()->sprite.getPosition().x, 5);
+}
+
+TEST(BasicsTest, ComponentLookup)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    EXPECT_FALSE(element->hasComponent<mate::Sprite>());
+    EXPECT_EQ(element->getComponent<mate::Sprite>(), nullptr);
+    EXPECT_TRUE(element->getComponents<mate::Sprite>().empty());
+
+    auto sprite = element->addComponent<mate::Sprite>();
+    auto second_sprite = element->addComponent<mate::Sprite>();
+    auto trigger = element->addComponent<mate::EmptyTrigger>();
+    EXPECT_TRUE(element->hasComponent<mate::Sprite>());
+    EXPECT_EQ(element->getComponent<mate::Sprite>(), sprite);
+    EXPECT_EQ(element->getComponents<mate::Sprite>().size(), 2);
+    EXPECT_EQ(element->getComponent<mate::EmptyTrigger>(), trigger);
+    EXPECT_FALSE(element->hasComponent<mate::InputActions>());
+
+    // Destroyed Components are dropped from the lookups on the next loop
+    sprite->destroy();
+    room->loop();
+    EXPECT_EQ(element->getComponent<mate::Sprite>(), second_sprite);
+    EXPECT_EQ(element->getComponents<mate::Sprite>().size(), 1);
+
+    // Stored Components are found too
+    room->useComponentStorage();
+    auto stored = room->addElement();
+    auto stored_sprite = stored->addComponent<mate::Sprite>();
+    EXPECT_EQ(stored->getComponent<mate::Sprite>(), stored_sprite);
+}
+
+TEST(BasicsTest, ElementsCountAfterNestedDestruction)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto top = room->addElement();
+    auto child = top->addChild();
+    auto grandchild = child->addChild();
+    grandchild->addChild();
+    grandchild->addChild();
+    child->addChild();
+    EXPECT_EQ(top->getElementsCount(), 1);
+    EXPECT_EQ(child->getElementsCount(), 2);
+    EXPECT_EQ(top->getFullElementsCount(), 5);
+
+    grandchild->destroy();
+    room->loop();
+    EXPECT_EQ(child->getElementsCount(), 1);
+    EXPECT_EQ(top->getFullElementsCount(), 2);
+
+    // Elements outliving their parent don't touch it
+    top->destroy();
+    room->loop();
+    EXPECT_EQ(top->getFullElementsCount(), 0);
+    top.reset();
+    child->addChild();
+    EXPECT_EQ(child->getFullElementsCount(), 2);
+}
+
+TEST(BasicsTest, RoomArena)
+{
+    auto room = std::make_shared<mate::Room>();
+    std::weak_ptr<mate::RoomArena> arena = room->getArena();
+    const std::size_t blocks = arena.lock()->getUsedBlocks();
+
+    auto element = room->addElement();
+    EXPECT_EQ(element->getArena(), room->getArena());
+    auto child = element->addChild();
+    EXPECT_EQ(child->getArena(), room->getArena());
+    auto sprite = child->addComponent<mate::Sprite>();
+    child->addComponent<mate::EmptyTrigger>();
+    EXPECT_GT(arena.lock()->getUsedBlocks(), blocks);
+
+    // Freed blocks are reused instead of reserving more memory
+    for (int i = 0; i < 100; ++i)
+    {
+        element->addChild()->addComponent<mate::Sprite>();
+    }
+    const std::size_t reserved = arena.lock()->getReservedBytes();
+    const std::size_t used = arena.lock()->getUsedBlocks();
+    element->destroy();
+    room->loop();
+    element.reset();
+    EXPECT_LT(arena.lock()->getUsedBlocks(), used);
+    auto other = room->addElement();
+    for (int i = 0; i < 100; ++i)
+    {
+        other->addChild()->addComponent<mate::Sprite>();
+    }
+    EXPECT_EQ(arena.lock()->getReservedBytes(), reserved);
+
+    // Objects outliving the Room keep the arena until they are gone
+    room.reset();
+    EXPECT_FALSE(arena.expired());
+    EXPECT_EQ(sprite->getSprite()->depth, 0);
+    child.reset();
+    sprite.reset();
+    other.reset();
+    EXPECT_TRUE(arena.expired());
+}
+
+TEST(BasicsTest, ElementPool)
+{
+    auto room = std::make_shared<mate::Room>();
+    int built = 0;
+    int resets = 0;
+    auto pool = std::make_shared<mate::ElementPool>(
+        room,
+        [&built](const std::shared_ptr<mate::Element> &element) {
+            element->addComponent<mate::Sprite>();
+            element->addComponent<mate::EmptyTrigger>()->subscribe();
+            element->addChild();
+            ++built;
+        },
+        [&resets](const std::shared_ptr<mate::Element> &element) {
+            element->setPosition(0, 0);
+            ++resets;
+        });
+
+    auto bullet = pool->spawn();
+    EXPECT_TRUE(bullet->isPooled());
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 1);
+    auto sprite = bullet->getComponent<mate::Sprite>();
+    auto trigger = bullet->getComponent<mate::EmptyTrigger>();
+    EXPECT_EQ(room->findTrigger(trigger->getHandle()), trigger);
+
+    // Destroyed bullets go back to the pool whole
+    bullet->destroy();
+    room->loop();
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 0);
+    EXPECT_EQ(pool->getFreeCount(), 1);
+    EXPECT_FALSE(sprite->shouldDestroy());
+    EXPECT_TRUE(sprite->isSleeping());
+    EXPECT_EQ(room->findTrigger(trigger->getHandle()), nullptr);
+    EXPECT_EQ(bullet->getElementsCount(), 1);
+
+    auto reused = pool->spawn();
+    EXPECT_EQ(reused, bullet);
+    EXPECT_EQ(reused->getComponent<mate::Sprite>(), sprite);
+    EXPECT_FALSE(reused->shouldDestroy());
+    EXPECT_FALSE(sprite->isSleeping());
+    EXPECT_EQ(room->findTrigger(trigger->getHandle()), trigger);
+    EXPECT_EQ(built, 1);
+    EXPECT_EQ(resets, 1);
+
+    pool->reserve(3);
+    EXPECT_EQ(pool->getFreeCount(), 3);
+    EXPECT_EQ(pool->getBuiltCount(), 4);
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 1);
+
+    // Without its pool the Element is destroyed as usual
+    pool.reset();
+    EXPECT_FALSE(reused->isPooled());
+    reused->destroy();
+    room->loop();
+    EXPECT_TRUE(sprite->shouldDestroy());
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 0);
+}
+
+TEST(BasicsTest, PhaseDispatch)
+{
+    static_assert(mate::overrides_render_loop<PhaseCounter>);
+    static_assert(mate::overrides_window_resize_event<PhaseCounter>);
+    static_assert(!mate::overrides_render_loop<LoopOnly>);
+    static_assert(!mate::overrides_window_resize_event<LoopOnly>);
+    static_assert(mate::overrides_render_loop<mate::Trigger>);
+    static_assert(!mate::overrides_render_loop<mate::InputActions>);
+
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    auto counter = element->addComponent<PhaseCounter>();
+    element->addComponent<LoopOnly>();
+    auto child_counter = element->addChild()->addComponent<PhaseCounter>();
+
+    // Every child is visited once per phase
+    room->loop();
+    room->renderLoop();
+    room->windowResizeEvent();
+    EXPECT_EQ(counter->loops, 1);
+    EXPECT_EQ(counter->render_loops, 1);
+    EXPECT_EQ(counter->resize_events, 1);
+    EXPECT_EQ(child_counter->render_loops, 1);
+    EXPECT_EQ(child_counter->resize_events, 1);
+
+    // Destroyed Components leave the phase lists
+    counter->destroy();
+    room->loop();
+    counter.reset();
+    room->renderLoop();
+    room->windowResizeEvent();
+    EXPECT_EQ(child_counter->render_loops, 2);
+}
+
+TEST(BasicsTest, CommandBuffer)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    auto counter = element->addComponent<PhaseCounter>();
+    mate::CommandBuffer *commands = element->getCommands();
+    ASSERT_EQ(commands, &room->getCommands());
+
+    // Nothing changes until the sync point at the end of Room::loop()
+    std::shared_ptr<mate::Element> spawned;
+    commands->addElement([&spawned](const std::shared_ptr<mate::Element> &new_element) {
+        new_element->setPosition(7, 8);
+        spawned = new_element;
+    });
+    commands->addChild(element);
+    commands->addComponent<LoopOnly>(element);
+    commands->destroy(counter);
+    EXPECT_EQ(commands->size(), 4);
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 1);
+    EXPECT_EQ(element->getElementsCount(), 0);
+    EXPECT_FALSE(counter->shouldDestroy());
+
+    room->loop();
+    EXPECT_EQ(commands->size(), 0);
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 2);
+    ASSERT_NE(spawned, nullptr);
+    EXPECT_FLOAT_EQ(spawned->getPosition().x, 7);
+    EXPECT_EQ(element->getElementsCount(), 1);
+    EXPECT_TRUE(element->hasComponent<LoopOnly>());
+    EXPECT_TRUE(counter->shouldDestroy());
+    EXPECT_EQ(counter->loops, 1);
+
+    // The destroyed Component is removed on the next loop
+    room->loop();
+    EXPECT_FALSE(element->hasComponent<PhaseCounter>());
+
+    // Commands on Elements that are gone are skipped
+    commands->setParent(spawned, element);
+    commands->addChild(spawned);
+    spawned->destroy();
+    room->loop();
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 1);
+    EXPECT_EQ(spawned->getElementsCount(), 0);
+    EXPECT_EQ(spawned->getParentCoords(), element.get());
+}
+
+TEST(BasicsTest, JobSystem)
+{
+    mate::JobSystem jobs(4);
+    EXPECT_EQ(jobs.size(), 4);
+    EXPECT_FALSE(mate::JobSystem::insideJob());
+
+    // Nested parallelFor and spawned jobs all finish before run() returns
+    std::atomic<int> sum = 0;
+    std::atomic<int> spawned = 0;
+    jobs.parallelFor(16, [&](const std::size_t i) {
+        EXPECT_TRUE(mate::JobSystem::insideJob());
+        jobs.parallelFor(10, [&](const std::size_t j) { sum += static_cast<int>(i * 10 + j); });
+        jobs.spawn([&spawned]() { ++spawned; });
+    });
+    EXPECT_EQ(sum, 159 * 160 / 2);
+    EXPECT_EQ(spawned, 16);
+
+    // Released objects outlive the batch
+    auto kept = std::make_shared<int>(3);
+    std::weak_ptr<int> weak_kept = kept;
+    jobs.run({[&kept, &weak_kept]() {
+        mate::JobSystem::deferRelease(std::move(kept));
+        EXPECT_FALSE(weak_kept.expired());
+    }});
+    EXPECT_TRUE(weak_kept.expired());
+}
+
+TEST(BasicsTest, ParallelRoomLoop)
+{
+    auto room = std::make_shared<mate::Room>();
+    room->setLoopThreads(4);
+    std::vector<std::shared_ptr<mate::Element>> elements;
+    std::vector<std::shared_ptr<ThreadedCounter>> counters;
+    for (int i = 0; i < 64; ++i)
+    {
+        elements.push_back(room->addElement());
+        counters.push_back(elements.back()->addChild()->addComponent<ThreadedCounter>());
+        // Children Elements destroyed from other threads
+        counters.back()->lifetime = i % 2 ? 2 : -1;
+        if (i % 8 == 0)
+        {
+            // Top Elements destroyed from other threads
+            elements.back()->addComponent<ThreadedCounter>()->lifetime = 3;
+        }
+    }
+    auto main_element = room->addElement();
+    auto probe = main_element->addComponent<MainThreadProbe>();
+    EXPECT_EQ(main_element->getMainThreadComponentsCount(), 1);
+    EXPECT_EQ(elements[0]->getMainThreadComponentsCount(), 0);
+
+    for (int frame = 0; frame < 4; ++frame)
+    {
+        room->loop();
+    }
+    EXPECT_EQ(probe->thread, std::this_thread::get_id());
+    EXPECT_EQ(room->getJobSystem().size(), 4);
+    EXPECT_EQ(room->getLoopTypeCount<mate::Element>(), 65 - 8);
+    for (std::size_t i = 0; i < counters.size(); ++i)
+    {
+        EXPECT_EQ(counters[i]->loops, i % 2 ? 2 : (i % 8 == 0 ? 3 : 4));
+        if (i % 8 != 0)
+        {
+            EXPECT_EQ(elements[i]->getElementsCount(), i % 2 ? 0 : 1);
+        }
+    }
+
+    probe->destroy();
+    room->loop();
+    EXPECT_EQ(main_element->getMainThreadComponentsCount(), 0);
+
+    // Components destroyed from other threads are purged on the thread running the Room, their nodes are on its arena
+    const std::size_t used_blocks = room->getArena()->getUsedBlocks();
+    std::vector<std::shared_ptr<mate::Element>> hosts;
+    for (int i = 0; i < 32; ++i)
+    {
+        hosts.push_back(room->addElement());
+        for (int j = 0; j < 16; ++j)
+        {
+            auto counter = hosts.back()->addComponent<ThreadedCounter>();
+            counter->lifetime = j % 4 ? 1 + j % 3 : -1;
+            counter->only_itself = true;
+        }
+    }
+    for (int frame = 0; frame < 3; ++frame)
+    {
+        room->loop();
+        for (const auto &host : hosts)
+        {
+            // Purged on the sync point of the frame
+            for (const auto &counter : host->getComponents<ThreadedCounter>())
+            {
+                EXPECT_FALSE(counter->shouldDestroy());
+            }
+        }
+    }
+    for (const auto &host : hosts)
+    {
+        EXPECT_EQ(host->getComponents<ThreadedCounter>().size(), 4);
+        host->destroy();
+    }
+    room->loop();
+    hosts.clear();
+    EXPECT_EQ(room->getArena()->getUsedBlocks(), used_blocks);
+}
+
+TEST(BasicsTest, FixedTimestep)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto game = mate::Game::getGame(400, 800, "MyGame", room);
+    game->setFixedStep(sf::milliseconds(10));
+    game->setMaxTicksPerFrame(4);
+    auto element = room->addElement();
+    auto counter = element->addComponent<PhaseCounter>();
+
+    // Ticks follow the real time, the rest waits for the next frame
+    EXPECT_EQ(game->simulate(sf::milliseconds(25)), 2);
+    EXPECT_EQ(counter->loops, 2);
+    EXPECT_NEAR(game->getInterpolation(), 0.5f, 1e-4f);
+    EXPECT_EQ(game->simulate(sf::milliseconds(5)), 1);
+    EXPECT_NEAR(game->getInterpolation(), 0, 1e-4f);
+    EXPECT_EQ(room->getDeltaTime(), sf::milliseconds(10));
+
+    // Long frames are capped instead of spiraling
+    EXPECT_EQ(game->simulate(sf::milliseconds(1000)), 4);
+    EXPECT_LT(game->getInterpolation(), 1);
+    EXPECT_EQ(game->simulate(sf::Time::Zero), 0);
+
+    // Without a fixed step every frame is one tick
+    game->setFixedStep(sf::Time::Zero);
+    EXPECT_EQ(game->simulate(sf::milliseconds(3)), 1);
+    EXPECT_EQ(room->getDeltaTime(), sf::milliseconds(3));
+    EXPECT_EQ(game->getInterpolation(), 1);
+}
+
+TEST(BasicsTest, SpriteInterpolation)
+{
+    auto room = std::make_shared<mate::Room>();
+    auto element = room->addElement();
+    element->setPosition(0, 0);
+    auto sprite = element->addComponent<mate::Sprite>();
+    room->loop();
+    element->setPosition(10, 20);
+    element->setRotation(350);
+    room->loop();
+
+    room->setInterpolation(0.5f);
+    room->renderLoop();
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().x, 5);
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().y, 10);
+    // Rotates the short way, from 0 to -10
+    EXPECT_NEAR(sprite->getSprite()->sprite.getRotation(), 355, 1e-3f);
+
+    room->setInterpolation(1);
+    room->renderLoop();
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().x, 10);
+
+    sprite->setInterpolation(false);
+    room->setInterpolation(0);
+    room->renderLoop();
+    EXPECT_FLOAT_EQ(sprite->getSprite()->sprite.getPosition().x, 10);
+}
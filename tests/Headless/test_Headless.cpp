@@ -0,0 +1,216 @@
+#include "GDMBasics.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace
+{
+class TickCounter : public mate::Component
+{
+  public:
+    int ticks = 0;
+    sf::Time simulated;
+
+    explicit TickCounter(const std::weak_ptr<mate::Element> &parent) : Component(parent)
+    {
+    }
+
+    void loop() override
+    {
+        ++ticks;
+        simulated += getDeltaTime();
+    }
+};
+
+class ContactCounter : public mate::Trigger
+{
+  public:
+    int contacts = 0;
+
+    explicit ContactCounter(const std::weak_ptr<mate::Element> &parent) : Trigger(parent)
+    {
+    }
+
+    void fireTrigger(const std::shared_ptr<Trigger> &trigger_by) override
+    {
+        ++contacts;
+    }
+};
+} // namespace
+
+// The first getGame() of the process chooses the mode, so every test of this executable is headless
+TEST(HeadlessTest, NullWindow)
+{
+    auto game = mate::Game::getGame(mate::HEADLESS);
+    ASSERT_TRUE(game->isHeadless());
+    EXPECT_EQ(mate::Game::getGame(), game);
+    EXPECT_EQ(mate::Game::getGame(mate::WINDOWED)->getMode(), mate::HEADLESS);
+
+    EXPECT_EQ(game->getWindowSize(), sf::Vector2u(800, 400));
+    game->setWindowSize(640, 480);
+    game->setWindowPosition(10, 20);
+    EXPECT_EQ(game->getWindowSize(), sf::Vector2u(640, 480));
+    EXPECT_EQ(game->getWindowPosition(), sf::Vector2i(10, 20));
+
+    game->setWindowView();
+    EXPECT_EQ(game->getView(0).getSize(), sf::Vector2f(640, 480));
+
+    auto target_id = game->addSecondaryTarget(sf::View(sf::FloatRect(0, 0, 100, 50)), "");
+    EXPECT_NE(target_id, 0);
+    EXPECT_EQ(game->getView(target_id).getSize(), sf::Vector2f(100, 50));
+    EXPECT_EQ(game->getWindowSize(target_id), sf::Vector2u(800, 400));
+}
+
+TEST(HeadlessTest, FramesRunOneStep)
+{
+    auto game = mate::Game::getGame(mate::HEADLESS);
+    auto room = game->getActiveRoom();
+    ASSERT_NE(room, nullptr);
+    auto counter = room->addElement()->addComponent<TickCounter>();
+
+    // Without a fixed step every frame simulates 1/60 of a second, no matter the real time elapsed
+    for (int i = 0; i < 30; ++i)
+    {
+        game->runSingleFrame();
+    }
+    EXPECT_EQ(counter->ticks, 30);
+    const sf::Time default_steps = sf::microseconds(sf::seconds(1.f / 60).asMicroseconds() * 30);
+    EXPECT_EQ(counter->simulated, default_steps);
+
+    game->setFixedStep(sf::milliseconds(10));
+    for (int i = 0; i < 30; ++i)
+    {
+        game->runSingleFrame();
+    }
+    EXPECT_EQ(counter->ticks, 60);
+    EXPECT_EQ(counter->simulated, default_steps + sf::milliseconds(300));
+    EXPECT_EQ(game->getInterpolation(), 0);
+    game->setFixedStep(sf::Time::Zero);
+}
+
+TEST(HeadlessTest, DrawCallsCounted)
+{
+    auto game = mate::Game::getGame(mate::HEADLESS);
+    auto room = game->getActiveRoom();
+    auto camera = room->addElement()->addComponent<mate::Camera>();
+
+    std::vector<std::shared_ptr<mate::Element>> elements;
+    for (int i = 0; i < 5; ++i)
+    {
+        elements.push_back(room->addElement());
+        camera->addSprite(elements.back()->addComponent<mate::Sprite>());
+    }
+
+    game->runSingleFrame();
+    EXPECT_EQ(game->getDrawCalls(), 5);
+
+    // Draw calls are counted per frame
+    game->runSingleFrame();
+    EXPECT_EQ(game->getDrawCalls(), 5);
+
+    elements.front()->destroy();
+    elements.erase(elements.begin());
+    game->runSingleFrame();
+    EXPECT_EQ(game->getDrawCalls(), 4);
+}
+
+TEST(HeadlessTest, IndependentGames)
+{
+    auto default_game = mate::Game::getGame(mate::HEADLESS);
+    auto game_a = mate::Game::create(mate::HEADLESS);
+    auto game_b = mate::Game::create(mate::HEADLESS);
+    EXPECT_NE(game_a, default_game);
+    EXPECT_NE(game_a, game_b);
+    EXPECT_EQ(game_a->getActiveRoom()->getGame(), game_a);
+    EXPECT_NE(game_a->getActiveRoom(), game_b->getActiveRoom());
+
+    // Render targets are numbered per Game
+    const sf::View view(sf::FloatRect(0, 0, 10, 10));
+    EXPECT_EQ(game_a->addSecondaryTarget(view, ""), 1);
+    EXPECT_EQ(game_b->addSecondaryTarget(view, ""), 1);
+    EXPECT_EQ(game_a->addSecondaryTarget(view, ""), 2);
+
+    // Cameras draw on the Game of their Room
+    auto camera = game_a->getActiveRoom()->addElement()->addComponent<mate::Camera>();
+    camera->addSprite(game_a->getActiveRoom()->addElement()->addComponent<mate::Sprite>());
+    const std::size_t default_draws = default_game->getDrawCalls();
+    game_a->runSingleFrame();
+    game_b->runSingleFrame();
+    EXPECT_EQ(game_a->getDrawCalls(), 1);
+    EXPECT_EQ(game_b->getDrawCalls(), 0);
+    EXPECT_EQ(default_game->getDrawCalls(), default_draws);
+
+    // Cameras of Rooms outside every Game draw nowhere, the default Game isn't used behind their back
+    auto loose_room = std::make_shared<mate::Room>();
+    auto loose_camera = loose_room->addElement()->addComponent<mate::Camera>();
+    loose_camera->addSprite(loose_room->addElement()->addComponent<mate::Sprite>());
+    loose_room->renderLoop();
+    loose_room->windowResizeEvent();
+    EXPECT_EQ(loose_camera->useNewTarget(""), 0);
+    EXPECT_EQ(default_game->getDrawCalls(), default_draws);
+}
+
+TEST(HeadlessTest, GamesOnThreads)
+{
+    constexpr int games_count = 4;
+    constexpr int frames = 120;
+    std::vector<std::shared_ptr<mate::Game>> games;
+    std::vector<int> ticks(games_count);
+    std::vector<int> contacts(games_count);
+    std::vector<std::size_t> draw_calls(games_count);
+
+    for (int i = 0; i < games_count; ++i)
+    {
+        games.push_back(mate::Game::create(mate::HEADLESS));
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < games_count; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            const auto &game = games[i];
+            auto room = game->getActiveRoom();
+            auto camera = room->addElement()->addComponent<mate::Camera>();
+
+            // Every frame spawns and destroys Elements, two of them overlapping Triggers
+            std::vector<std::shared_ptr<mate::Element>> elements;
+            auto counter = room->addElement()->addComponent<TickCounter>();
+            auto trigger_a = room->addElement()->addComponent<ContactCounter>();
+            auto trigger_b = room->addElement()->addComponent<ContactCounter>();
+            for (const auto &trigger : {trigger_a, trigger_b})
+            {
+                trigger->setDimensions(2, 2);
+                trigger->setShape(mate::ShapeType::CIRCLE);
+                trigger->subscribe();
+            }
+
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                auto element = room->addElement();
+                camera->addSprite(element->addComponent<mate::Sprite>());
+                elements.push_back(element);
+                if (elements.size() > 8)
+                {
+                    elements.front()->destroy();
+                    elements.erase(elements.begin());
+                }
+                game->runSingleFrame();
+            }
+            ticks[i] = counter->ticks;
+            contacts[i] = trigger_a->contacts;
+            draw_calls[i] = game->getDrawCalls();
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int i = 0; i < games_count; ++i)
+    {
+        EXPECT_EQ(ticks[i], frames);
+        EXPECT_EQ(contacts[i], contacts[0]);
+        EXPECT_GT(contacts[i], 0);
+        EXPECT_EQ(draw_calls[i], 8);
+        EXPECT_EQ(games[i]->getActiveRoom()->getLoopTypeCount<mate::Element>(), 12);
+    }
+}
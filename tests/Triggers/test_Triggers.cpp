@@ -1,5 +1,8 @@
 #include "GDMBasics.h"
 #include <gtest/gtest.h>
+#include <map>
+#include <random>
+#include <set>
 
 /**
  * Tests Triggers coordinates by moving it and the element that holds it
@@ -152,3 +155,977 @@ TEST(TriggersTest, TriggerActivation){
     EXPECT_EQ(mate::TestTrigger::count, starting_count+6);
 }
 
+
+namespace mate{
+    class RecordTrigger : public Trigger{
+        public:
+        explicit RecordTrigger(const std::weak_ptr<Element> &parent) : Trigger(parent){}
+        static std::vector<std::pair<const Trigger*, const Trigger*>> fired;
+        void fireTrigger(const std::shared_ptr<Trigger>& trigger_by) override
+        {
+            fired.emplace_back(this, trigger_by.get());
+        }
+    };
+
+    std::vector<std::pair<const Trigger*, const Trigger*>> RecordTrigger::fired = {};
+}
+
+/**
+ * Moves a set of random Triggers around and records every fireTrigger call.
+ */
+std::vector<std::pair<const mate::Trigger*, const mate::Trigger*>> recordFrames(
+    const std::shared_ptr<mate::Room> &room, const std::vector<std::shared_ptr<mate::Element>> &elements)
+{
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<float> position(-300, 300);
+    std::uniform_real_distribution<float> step(-20, 20);
+
+    for (const auto &element : elements)
+    {
+        element->setPosition(position(generator), position(generator));
+    }
+
+    mate::RecordTrigger::fired.clear();
+    for (int frame = 0; frame < 10; ++frame)
+    {
+        room->loop();
+        room->renderLoop();
+        for (const auto &element : elements)
+        {
+            element->move(step(generator), step(generator));
+        }
+    }
+    return mate::RecordTrigger::fired;
+}
+
+TEST(TriggersTest, SpatialHashMatchesBruteForce){
+    auto room = std::make_shared<mate::Room>();
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> size(1, 40);
+
+    std::vector<std::shared_ptr<mate::Element>> elements;
+    for (int i = 0; i < 200; ++i)
+    {
+        auto element = room->addElement();
+        auto trigger = element->addComponent<mate::RecordTrigger>();
+        trigger->setDimensions(size(generator), size(generator));
+        trigger->setShape(i % 3 == 0 ? mate::ShapeType::CIRCLE : mate::ShapeType::RECTANGLE);
+        // Some Triggers on a second layer, some of them ignoring the first one
+        trigger->setCategory(i % 5 == 0 ? 0b10 : 0b01);
+        trigger->setCollisionMask(i % 7 == 0 ? 0b10 : 0b11);
+        trigger->subscribe();
+        elements.push_back(element);
+    }
+    // A huge Trigger that goes to the oversized list of the grid
+    elements.front()->setScale(100, 100);
+
+    room->setTriggerBroadPhase(mate::BroadPhaseType::BRUTE_FORCE);
+    auto brute_force = recordFrames(room, elements);
+    ASSERT_FALSE(brute_force.empty());
+
+    room->setTriggerBroadPhase(mate::BroadPhaseType::SPATIAL_HASH);
+    for (float cell_size : {8.0f, 64.0f, 500.0f})
+    {
+        room->setTriggerCellSize(cell_size);
+        EXPECT_EQ(recordFrames(room, elements), brute_force);
+    }
+
+    room->setTriggerBroadPhase(mate::BroadPhaseType::DYNAMIC_TREE);
+    for (float fat_margin : {0.0f, 4.0f, 50.0f})
+    {
+        room->setTriggerFatMargin(fat_margin);
+        EXPECT_EQ(recordFrames(room, elements), brute_force);
+    }
+
+    room->setTriggerBroadPhase(mate::BroadPhaseType::SWEEP_AND_PRUNE);
+    for (bool second_axis : {true, false})
+    {
+        room->setTriggerSweepSecondAxis(second_axis);
+        EXPECT_EQ(recordFrames(room, elements), brute_force);
+    }
+
+    // Splitting the narrow-phase doesn't change the results or their order
+    for (unsigned int threads : {2u, 3u, 0u})
+    {
+        room->setTriggerThreads(threads);
+        EXPECT_EQ(recordFrames(room, elements), brute_force);
+    }
+    room->setTriggerThreads(1);
+}
+
+TEST(TriggersTest, SpatialHashQuery){
+    mate::SpatialHash hash(10);
+    hash.insert(0, sf::FloatRect(0, 0, 5, 5));
+    hash.insert(1, sf::FloatRect(10, 0, 5, 5));
+    hash.insert(2, sf::FloatRect(-100000, -100000, 200000, 200000));
+    hash.insert(3, sf::FloatRect(25, 25, 1, 1));
+
+    std::vector<unsigned int> result;
+    hash.query(sf::FloatRect(4, 4, 2, 2), result);
+    EXPECT_EQ(result, (std::vector<unsigned int>{0, 2}));
+
+    // Touching the cell edge counts as sharing the cell
+    hash.query(sf::FloatRect(5, 0, 5, 1), result);
+    EXPECT_EQ(result, (std::vector<unsigned int>{0, 1, 2}));
+
+    hash.clear();
+    hash.insert(4, sf::FloatRect(25, 25, 1, 1));
+    hash.query(sf::FloatRect(20, 20, 1, 1), result);
+    EXPECT_EQ(result, (std::vector<unsigned int>{4}));
+    EXPECT_EQ(hash.size(), 1);
+}
+
+TEST(TriggersTest, DynamicTreePairs){
+    mate::DynamicTree tree(1);
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<float> position(-500, 500);
+    std::uniform_real_distribution<float> size(0, 30);
+    auto random_rect = [&]() {
+        return sf::FloatRect(position(generator), position(generator), size(generator), size(generator));
+    };
+
+    std::vector<int> proxies;
+    for (int i = 0; i < 500; ++i)
+    {
+        proxies.push_back(tree.createProxy(random_rect()));
+    }
+    for (int i = 0; i < 200; ++i)
+    {
+        tree.destroyProxy(proxies.back());
+        proxies.pop_back();
+    }
+    int reinserted = 0;
+    for (int proxy : proxies)
+    {
+        reinserted += tree.moveProxy(proxy, random_rect());
+    }
+    EXPECT_GT(reinserted, 0);
+    EXPECT_EQ(tree.getProxyCount(), 300);
+    // Balanced trees stay close to log2(300) ~ 8.2
+    EXPECT_LE(tree.getHeight(), 20);
+
+    std::set<std::pair<int, int>> expected;
+    for (std::size_t a = 0; a < proxies.size(); ++a)
+    {
+        for (std::size_t b = a + 1; b < proxies.size(); ++b)
+        {
+            if (mate::DynamicTree::overlaps(tree.getFatBounds(proxies[a]), tree.getFatBounds(proxies[b])))
+            {
+                expected.emplace(std::min(proxies[a], proxies[b]), std::max(proxies[a], proxies[b]));
+            }
+        }
+    }
+    std::set<std::pair<int, int>> found;
+    tree.queryPairs([&](int a, int b) { EXPECT_TRUE(found.emplace(std::min(a, b), std::max(a, b)).second); });
+    EXPECT_EQ(found, expected);
+
+    // Moving inside the fat bounds does not touch the tree
+    const sf::FloatRect fat = tree.getFatBounds(proxies.front());
+    EXPECT_FALSE(tree.moveProxy(proxies.front(), sf::FloatRect(fat.left + 1, fat.top + 1, 0, 0)));
+}
+
+TEST(TriggersTest, SweepAndPrunePairs){
+    mate::SweepAndPrune sweep;
+    sweep.insert(0, sf::FloatRect(0, 0, 10, 10));
+    sweep.insert(1, sf::FloatRect(10, 50, 10, 10));
+    sweep.insert(2, sf::FloatRect(-20, 5, 10, 10));
+    sweep.insert(3, sf::FloatRect(5, 5, 1, 1));
+    sweep.update();
+
+    auto pairs = [&](bool second_axis) {
+        std::set<std::pair<int, int>> found;
+        sweep.queryPairs(second_axis, [&](int a, int b) { found.emplace(std::min(a, b), std::max(a, b)); });
+        return found;
+    };
+    EXPECT_EQ(pairs(false), (std::set<std::pair<int, int>>{{0, 1}, {0, 3}}));
+    EXPECT_EQ(pairs(true), (std::set<std::pair<int, int>>{{0, 3}}));
+
+    // Small movements only need a few swaps
+    sweep.setBounds(2, sf::FloatRect(1, 5, 10, 10));
+    sweep.remove(3);
+    EXPECT_EQ(sweep.update(), 1);
+    EXPECT_EQ(sweep.size(), 3);
+    EXPECT_EQ(pairs(true), (std::set<std::pair<int, int>>{{0, 2}}));
+
+    // Churn without updates, as under the other broad-phases, doesn't grow the array
+    for (int i = 0; i < 1000; ++i)
+    {
+        sweep.insert(4, sf::FloatRect(i, 0, 1, 1));
+        sweep.remove(4);
+    }
+    EXPECT_EQ(sweep.size(), 3);
+    EXPECT_LE(sweep.getStoredCount(), 7);
+    sweep.update();
+    EXPECT_EQ(pairs(true), (std::set<std::pair<int, int>>{{0, 2}}));
+
+    // Bursts of insertions are merged without swaps, and found like any other entry
+    std::mt19937 generator(29);
+    std::uniform_real_distribution<float> position(-1000, 1000);
+    std::map<int, sf::FloatRect> bounds = {{0, {0, 0, 10, 10}}, {1, {10, 50, 10, 10}}, {2, {1, 5, 10, 10}}};
+    for (int id = 4; id < 2000; ++id)
+    {
+        bounds[id] = sf::FloatRect(position(generator), position(generator), 10, 10);
+        sweep.insert(id, bounds[id]);
+    }
+    EXPECT_EQ(sweep.update(), 0);
+    std::set<std::pair<int, int>> expected;
+    for (const auto &[id_a, a] : bounds)
+    {
+        for (const auto &[id_b, b] : bounds)
+        {
+            if (id_a < id_b && a.left <= b.left + b.width && b.left <= a.left + a.width &&
+                a.top <= b.top + b.height && b.top <= a.top + a.height)
+            {
+                expected.emplace(id_a, id_b);
+            }
+        }
+    }
+    EXPECT_EQ(pairs(true), expected);
+}
+
+TEST(TriggersTest, NarrowPhaseBatch){
+    mate::shape_buffer shapes;
+    std::mt19937 generator(5);
+    // Integer values make touching shapes and zero dimensions common
+    std::uniform_int_distribution<int> position(-20, 20);
+    std::uniform_int_distribution<int> size(-2, 12);
+
+    const int count = 301;
+    shapes.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        shapes.set(i, sf::Vector2f(position(generator), position(generator)),
+                   sf::Vector2f(size(generator), size(generator)), i % 2 == 0 ? mate::CIRCLE : mate::RECTANGLE);
+    }
+
+    std::vector<int> candidates(count - 1);
+    std::vector<int> hits(candidates.size());
+    for (int index = 0; index < count; ++index)
+    {
+        // Every other shape except index, in an order that's not contiguous in memory
+        for (int i = 0; i < count - 1; ++i)
+        {
+            candidates[i] = (index + 1 + i * 7) % count;
+            if (candidates[i] == index)
+            {
+                candidates[i] = (index + count - 1) % count;
+            }
+        }
+
+        std::vector<int> expected;
+        for (const int candidate : candidates)
+        {
+            if (mate::shapesCheck(static_cast<mate::ShapeType>(shapes.shape[candidate]),
+                                  {shapes.x[candidate], shapes.y[candidate]},
+                                  {shapes.width[candidate], shapes.height[candidate]},
+                                  static_cast<mate::ShapeType>(shapes.shape[index]), {shapes.x[index], shapes.y[index]},
+                                  {shapes.width[index], shapes.height[index]}))
+            {
+                expected.push_back(candidate);
+            }
+        }
+
+        const std::size_t found =
+            mate::shapesBatchCheck(shapes, index, candidates.data(), candidates.size(), hits.data());
+        ASSERT_EQ(std::vector<int>(hits.begin(), hits.begin() + found), expected);
+    }
+}
+
+TEST(TriggersTest, NarrowPhaseChecks){
+    // Circles are placed from the corner of their bounding square
+    EXPECT_TRUE(mate::circleToCircleCheck({0, 0}, {10, 10}, {9, 0}, {10, 10}));
+    EXPECT_FALSE(mate::circleToCircleCheck({0, 0}, {10, 10}, {10, 0}, {10, 10}));
+    EXPECT_FALSE(mate::circleToCircleCheck({0, 0}, {0, 0}, {0, 0}, {0, 0}));
+
+    // Rectangle beside the circle, above it and on its diagonal
+    EXPECT_TRUE(mate::circleToRectangleCheck({0, 0}, {10, 10}, {10, 2}, {5, 5}));
+    EXPECT_TRUE(mate::circleToRectangleCheck({0, 0}, {10, 10}, {2, -4}, {5, 5}));
+    EXPECT_TRUE(mate::circleToRectangleCheck({0, 0}, {10, 10}, {8, 8}, {5, 5}));
+    EXPECT_FALSE(mate::circleToRectangleCheck({0, 0}, {10, 10}, {9, 9}, {5, 5}));
+}
+
+namespace mate{
+    class EventTrigger : public Trigger{
+        public:
+        explicit EventTrigger(const std::weak_ptr<Element> &parent) : Trigger(parent){}
+        static std::vector<std::string> events;
+        void fireTrigger(const std::shared_ptr<Trigger>& trigger_by) override {}
+        void onEnter(const std::shared_ptr<Trigger>& trigger_by) override { events.push_back("enter"); }
+        void onStay(const std::shared_ptr<Trigger>& trigger_by) override { events.push_back("stay"); }
+        void onExit(const std::shared_ptr<Trigger>& trigger_by) override
+        {
+            events.push_back(trigger_by ? "exit" : "exit destroyed");
+        }
+    };
+
+    std::vector<std::string> EventTrigger::events = {};
+}
+
+TEST(TriggersTest, ContactEvents){
+    for (auto broad_phase : {mate::BRUTE_FORCE, mate::SWEEP_AND_PRUNE})
+    {
+        auto room = std::make_shared<mate::Room>();
+        room->setTriggerBroadPhase(broad_phase);
+        auto element_a = room->addElement();
+        auto element_b = room->addElement();
+        auto trigger_a = element_a->addComponent<mate::EventTrigger>();
+        auto trigger_b = element_b->addComponent<mate::EventTrigger>();
+        trigger_a->setDimensions(10, 10);
+        trigger_b->setDimensions(10, 10);
+        trigger_a->subscribe();
+        trigger_b->subscribe();
+        element_a->setPosition(0, 0);
+        element_b->setPosition(5, 5);
+
+        auto frame = [&]() {
+            mate::EventTrigger::events.clear();
+            room->loop();
+            room->renderLoop();
+            return mate::EventTrigger::events;
+        };
+        using events = std::vector<std::string>;
+
+        EXPECT_EQ(frame(), (events{"enter", "enter"}));
+        EXPECT_EQ(frame(), (events{"stay", "stay"}));
+        element_b->setPosition(50, 50);
+        EXPECT_EQ(frame(), (events{"exit", "exit"}));
+        EXPECT_EQ(frame(), events{});
+
+        // Unsubscribing ends the contact too
+        element_b->setPosition(5, 5);
+        EXPECT_EQ(frame(), (events{"enter", "enter"}));
+        trigger_b->unsubscribe();
+        EXPECT_EQ(frame(), (events{"exit", "exit"}));
+
+        // And so does destroying one of the Triggers
+        trigger_b->subscribe();
+        EXPECT_EQ(frame(), (events{"enter", "enter"}));
+        element_b->destroy();
+        element_b.reset();
+        trigger_b.reset();
+        auto destroyed = frame();
+        auto next = frame();
+        destroyed.insert(destroyed.end(), next.begin(), next.end());
+        EXPECT_EQ(destroyed, (events{"stay", "stay", "exit destroyed"}));
+
+        // The Room ends the contacts of purged Triggers even if no Trigger loops anymore
+        element_b = room->addElement();
+        trigger_b = element_b->addComponent<mate::EventTrigger>();
+        trigger_b->setDimensions(10, 10);
+        trigger_b->subscribe();
+        element_b->setPosition(5, 5);
+        EXPECT_EQ(frame(), (events{"enter", "enter"}));
+        element_a->destroy();
+        element_b->destroy();
+        element_b.reset();
+        trigger_b.reset();
+        EXPECT_EQ(frame(), (events{"exit destroyed"}));
+        EXPECT_EQ(frame(), events{});
+    }
+}
+
+TEST(TriggersTest, PairMap){
+    mate::PairMap<int> map;
+    std::map<std::pair<std::uint64_t, std::uint64_t>, int> expected;
+    std::mt19937 generator(13);
+    std::uniform_int_distribution<std::uint64_t> id(0, 40);
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::uint64_t a = id(generator);
+        std::uint64_t b = id(generator);
+        const auto key = std::minmax(a, b);
+        if (i % 3 == 0)
+        {
+            EXPECT_EQ(map.erase(a, b), expected.erase(key) == 1);
+        }
+        else
+        {
+            auto [value, inserted] = map.tryEmplace(b, a);
+            EXPECT_EQ(inserted, !expected.contains(key));
+            *value = i;
+            expected[key] = i;
+        }
+    }
+
+    EXPECT_EQ(map.size(), expected.size());
+    for (const auto &[key, value] : expected)
+    {
+        ASSERT_NE(map.find(key.second, key.first), nullptr);
+        EXPECT_EQ(*map.find(key.first, key.second), value);
+    }
+    std::size_t visited = 0;
+    map.forEach([&](std::uint64_t first, std::uint64_t second, int value) {
+        EXPECT_LT(first, second + 1);
+        EXPECT_EQ(expected.at({first, second}), value);
+        ++visited;
+    });
+    EXPECT_EQ(visited, expected.size());
+
+    // Steady state doesn't grow
+    const std::size_t capacity = map.capacity();
+    map.clear();
+    for (const auto &[key, value] : expected)
+    {
+        map.tryEmplace(key.first, key.second);
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(TriggersTest, TriggerLayers){
+    auto room = std::make_shared<mate::Room>();
+    std::vector<std::shared_ptr<mate::RecordTrigger>> triggers;
+    for (int i = 0; i < 3; ++i)
+    {
+        auto element = room->addElement();
+        element->setPosition(i, 0);
+        auto trigger = element->addComponent<mate::RecordTrigger>();
+        trigger->setDimensions(10, 10);
+        trigger->subscribe();
+        triggers.push_back(trigger);
+    }
+    // a and b collide with each other, c collides with a but a ignores c's layer
+    triggers[0]->setCategory(1 << 0);
+    triggers[0]->setCollisionMask(1 << 1);
+    triggers[1]->setCategory(1 << 1);
+    triggers[1]->setCollisionMask(1 << 0);
+    triggers[2]->setCategory(1 << 2);
+    EXPECT_TRUE(triggers[0]->canCollideWith(*triggers[1]));
+    EXPECT_FALSE(triggers[0]->canCollideWith(*triggers[2]));
+    EXPECT_FALSE(triggers[2]->canCollideWith(*triggers[0]));
+
+    for (auto broad_phase : {mate::BRUTE_FORCE, mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+    {
+        room->setTriggerBroadPhase(broad_phase);
+        mate::RecordTrigger::fired.clear();
+        room->loop();
+        room->renderLoop();
+        std::set<std::pair<const mate::Trigger *, const mate::Trigger *>> fired(mate::RecordTrigger::fired.begin(),
+                                                                              mate::RecordTrigger::fired.end());
+        EXPECT_EQ(fired, (std::set<std::pair<const mate::Trigger *, const mate::Trigger *>>{
+                             {triggers[0].get(), triggers[1].get()}, {triggers[1].get(), triggers[0].get()}}));
+    }
+}
+
+TEST(TriggersTest, StaticTriggers){
+    auto room = std::make_shared<mate::Room>();
+    std::mt19937 generator(17);
+    std::uniform_real_distribution<float> size(1, 40);
+    std::uniform_real_distribution<float> position(-300, 300);
+
+    std::vector<std::shared_ptr<mate::Element>> dynamic_elements;
+    std::vector<std::shared_ptr<mate::RecordTrigger>> static_triggers;
+    for (int i = 0; i < 150; ++i)
+    {
+        auto element = room->addElement();
+        auto trigger = element->addComponent<mate::RecordTrigger>();
+        trigger->setDimensions(size(generator), size(generator));
+        trigger->setShape(i % 3 == 0 ? mate::ShapeType::CIRCLE : mate::ShapeType::RECTANGLE);
+        if (i % 2 == 0)
+        {
+            // Static Triggers are placed once, recordFrames only moves the dynamic ones
+            trigger->setStatic(true);
+            element->setPosition(position(generator), position(generator));
+            static_triggers.push_back(trigger);
+        }
+        else
+        {
+            dynamic_elements.push_back(element);
+        }
+        trigger->subscribe();
+    }
+    // Switching the state of an active Trigger
+    static_triggers.back()->setStatic(false);
+    static_triggers.back()->setStatic(true);
+
+    room->setTriggerBroadPhase(mate::BroadPhaseType::BRUTE_FORCE);
+    auto brute_force = recordFrames(room, dynamic_elements);
+    ASSERT_FALSE(brute_force.empty());
+    for (const auto &[fired, by] : brute_force)
+    {
+        EXPECT_FALSE(fired->isStatic() && by->isStatic());
+    }
+
+    for (auto broad_phase : {mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+    {
+        room->setTriggerBroadPhase(broad_phase);
+        EXPECT_EQ(recordFrames(room, dynamic_elements), brute_force);
+    }
+
+    for (const auto &trigger : static_triggers)
+    {
+        trigger->unsubscribe();
+    }
+}
+
+TEST(TriggersTest, StaticTreeQuery){
+    std::mt19937 generator(19);
+    std::uniform_real_distribution<float> position(-500, 500);
+    std::uniform_real_distribution<float> size(0, 30);
+    auto random_rect = [&]() {
+        return sf::FloatRect(position(generator), position(generator), size(generator), size(generator));
+    };
+
+    std::vector<mate::StaticTree::item> items;
+    for (int i = 0; i < 500; ++i)
+    {
+        items.push_back({random_rect(), i});
+    }
+    mate::StaticTree tree;
+    tree.build(items);
+    EXPECT_EQ(tree.size(), 500);
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const sf::FloatRect bounds = random_rect();
+        std::set<int> expected;
+        for (const auto &item : items)
+        {
+            if (mate::DynamicTree::overlaps(item.bounds, bounds))
+            {
+                expected.insert(item.id);
+            }
+        }
+        std::set<int> found;
+        tree.query(bounds, [&](int id) { EXPECT_TRUE(found.insert(id).second); });
+        EXPECT_EQ(found, expected);
+    }
+}
+
+TEST(TriggersTest, SpatialQueries){
+    auto room = std::make_shared<mate::Room>();
+    std::mt19937 generator(23);
+    std::uniform_real_distribution<float> size(1, 40);
+    std::uniform_real_distribution<float> position(-300, 300);
+
+    std::vector<std::shared_ptr<mate::RecordTrigger>> triggers;
+    for (int i = 0; i < 150; ++i)
+    {
+        auto element = room->addElement();
+        element->setPosition(position(generator), position(generator));
+        auto trigger = element->addComponent<mate::RecordTrigger>();
+        trigger->setDimensions(size(generator), size(generator));
+        trigger->setShape(i % 3 == 0 ? mate::ShapeType::CIRCLE : mate::ShapeType::RECTANGLE);
+        trigger->setCategory(i % 4 == 0 ? 0b10 : 0b01);
+        trigger->setStatic(i % 5 == 0);
+        trigger->subscribe();
+        triggers.push_back(trigger);
+    }
+    triggers[1]->unsubscribe();
+
+    // Triggers of other Rooms are never reported
+    auto other_room = std::make_shared<mate::Room>();
+    auto other_trigger = other_room->addElement()->addComponent<mate::RecordTrigger>();
+    other_trigger->setDimensions(1000, 1000);
+    other_trigger->setPosition(-500, -500);
+    other_trigger->subscribe();
+
+    auto brute_force = [&](auto &&test, std::uint32_t mask) {
+        std::vector<std::shared_ptr<mate::Trigger>> expected;
+        for (const auto &trigger : triggers)
+        {
+            if (trigger != triggers[1] && (trigger->getCategory() & mask) != 0 &&
+                test(trigger->getShape(), trigger->getPosition(), trigger->getDimensions()))
+            {
+                expected.push_back(trigger);
+            }
+        }
+        return expected;
+    };
+
+    std::vector<std::shared_ptr<mate::Trigger>> result;
+    std::vector<mate::raycast_hit> hits;
+    for (auto broad_phase : {mate::BRUTE_FORCE, mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+    {
+        room->setTriggerBroadPhase(broad_phase);
+        room->loop();
+        room->renderLoop();
+
+        std::size_t found = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            const std::uint32_t mask = i % 3 == 0 ? 0b10 : 0xFFFFFFFF;
+            const sf::Vector2f point(position(generator), position(generator));
+            const sf::Vector2f dimensions(size(generator), size(generator));
+            const float radius = size(generator);
+
+            const std::size_t count = room->queryPoint(point, result, mask);
+            EXPECT_EQ(count, result.size());
+            EXPECT_EQ(result, brute_force([&](auto shape, auto pos, auto dim) {
+                return mate::pointToShapeCheck(point, shape, pos, dim); }, mask));
+            found += result.size();
+
+            room->queryRect({point, dimensions}, result, mask);
+            EXPECT_EQ(result, brute_force([&](auto shape, auto pos, auto dim) {
+                return mate::shapesCheck(mate::RECTANGLE, point, dimensions, shape, pos, dim); }, mask));
+            found += result.size();
+
+            room->queryCircle(point, radius, result, mask);
+            EXPECT_EQ(result, brute_force([&](auto shape, auto pos, auto dim) {
+                return mate::shapesCheck(mate::CIRCLE, point - sf::Vector2f(radius, radius), {2 * radius, 2 * radius},
+                                         shape, pos, dim); }, mask));
+            found += result.size();
+
+            // Every Trigger crossed by the ray, compared without the order
+            const sf::Vector2f direction(position(generator), position(generator));
+            room->raycastAll(point, direction, 200, hits, mask);
+            const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+            std::set<mate::Trigger *> hit_triggers;
+            for (std::size_t hit = 0; hit < hits.size(); ++hit)
+            {
+                hit_triggers.insert(hits[hit].trigger.get());
+                EXPECT_TRUE(hit == 0 || hits[hit - 1].distance <= hits[hit].distance);
+            }
+            std::set<mate::Trigger *> expected_hits;
+            for (const auto &trigger : brute_force([&](auto shape, auto pos, auto dim) {
+                     float distance;
+                     return mate::rayToShapeCheck(point, direction / length, 200, shape, pos, dim, distance); }, mask))
+            {
+                expected_hits.insert(trigger.get());
+            }
+            EXPECT_EQ(hit_triggers, expected_hits);
+            found += hits.size();
+
+            mate::raycast_hit closest;
+            EXPECT_EQ(room->raycast(point, direction, 200, closest, mask), !hits.empty());
+            if (!hits.empty())
+            {
+                EXPECT_EQ(closest.distance, hits.front().distance);
+                EXPECT_EQ(closest.trigger, hits.front().trigger);
+            }
+        }
+        EXPECT_GT(found, 0);
+    }
+
+    for (const auto &trigger : triggers)
+    {
+        trigger->unsubscribe();
+    }
+    other_trigger->unsubscribe();
+}
+
+TEST(TriggersTest, Raycast){
+    auto room = std::make_shared<mate::Room>();
+    std::vector<std::shared_ptr<mate::RecordTrigger>> triggers;
+    // A row of boxes on the horizontal axis and a circle behind them
+    for (float x : {10.0f, 30.0f, 50.0f})
+    {
+        auto trigger = room->addElement()->addComponent<mate::RecordTrigger>();
+        trigger->setPosition(x, -5);
+        trigger->setDimensions(10, 10);
+        trigger->subscribe();
+        triggers.push_back(trigger);
+    }
+    auto circle = room->addElement()->addComponent<mate::RecordTrigger>();
+    circle->setShape(mate::CIRCLE);
+    circle->setPosition(70, -10);
+    circle->setDimensions(20, 20);
+    circle->setStatic(true);
+    circle->subscribe();
+    triggers.push_back(circle);
+
+    mate::raycast_hit hit;
+    ASSERT_TRUE(room->raycast({0, 0}, {2, 0}, 100, hit));
+    EXPECT_EQ(hit.trigger, triggers[0]);
+    EXPECT_FLOAT_EQ(hit.distance, 10);
+    EXPECT_FLOAT_EQ(hit.point.x, 10);
+    EXPECT_FLOAT_EQ(hit.point.y, 0);
+
+    std::vector<mate::raycast_hit> hits;
+    EXPECT_EQ(room->raycastAll({0, 0}, {1, 0}, 100, hits), 4);
+    std::vector<float> distances;
+    for (const auto &current : hits)
+    {
+        distances.push_back(current.distance);
+    }
+    EXPECT_EQ(distances, (std::vector<float>{10, 30, 50, 70}));
+    EXPECT_EQ(hits.back().trigger, circle);
+
+    // Short rays, rays starting inside a Trigger, rays going away and layers
+    EXPECT_EQ(room->raycastAll({0, 0}, {1, 0}, 29, hits), 1);
+    EXPECT_EQ(room->raycastAll({35, 0}, {1, 0}, 100, hits), 3);
+    EXPECT_FLOAT_EQ(hits.front().distance, 0);
+    EXPECT_FALSE(room->raycast({0, 0}, {-1, 0}, 100, hit));
+    EXPECT_FALSE(room->raycast({0, 0}, {0, 0}, 100, hit));
+    EXPECT_FALSE(room->raycast({0, 0}, {1, 0}, 100, hit, 0b10));
+    circle->setCategory(0b10);
+    ASSERT_TRUE(room->raycast({0, 0}, {1, 0}, 100, hit, 0b10));
+    EXPECT_EQ(hit.trigger, circle);
+    EXPECT_FLOAT_EQ(hit.distance, 70);
+
+    // Missing the circle by its corner
+    EXPECT_FALSE(room->raycast({60, 2}, {1, -1}, 100, hit, 0b10));
+
+    for (const auto &trigger : triggers)
+    {
+        trigger->unsubscribe();
+    }
+}
+
+TEST(TriggersTest, RoomWorlds){
+    // Two Rooms with the same superposed Triggers, only the Room that runs fires them
+    auto room_a = std::make_shared<mate::Room>();
+    auto room_b = std::make_shared<mate::Room>();
+    std::vector<std::shared_ptr<mate::RecordTrigger>> triggers;
+    for (const auto &room : {room_a, room_a, room_b, room_b})
+    {
+        auto trigger = room->addElement()->addComponent<mate::RecordTrigger>();
+        trigger->setDimensions(10, 10);
+        trigger->subscribe();
+        triggers.push_back(trigger);
+    }
+
+    mate::RecordTrigger::fired.clear();
+    room_a->loop();
+    room_a->renderLoop();
+    EXPECT_EQ(mate::RecordTrigger::fired,
+              (std::vector<std::pair<const mate::Trigger *, const mate::Trigger *>>{
+                  {triggers[0].get(), triggers[1].get()}, {triggers[1].get(), triggers[0].get()}}));
+
+    // Handles
+    const mate::trigger_handle handle = triggers[1]->getHandle();
+    EXPECT_EQ(room_a->findTrigger(handle), triggers[1]);
+    EXPECT_EQ(room_b->findTrigger(triggers[3]->getHandle()), triggers[3]);
+    triggers[1]->unsubscribe();
+    EXPECT_EQ(room_a->findTrigger(handle), nullptr);
+    // The proxy is reused by a new subscription, the old handle still fails
+    room_a->loop();
+    room_a->renderLoop();
+    triggers[1]->subscribe();
+    EXPECT_EQ(room_a->findTrigger(handle), nullptr);
+    EXPECT_EQ(room_a->findTrigger(triggers[1]->getHandle()), triggers[1]);
+    EXPECT_EQ(room_a->findTrigger(mate::trigger_handle{}), nullptr);
+
+    // Destroyed Triggers leave their world right away
+    const mate::trigger_handle destroyed = triggers[3]->getHandle();
+    triggers[3].reset();
+    room_b.reset();
+    std::vector<std::shared_ptr<mate::Trigger>> result;
+    EXPECT_EQ(room_a->queryPoint({5, 5}, result), 2);
+    EXPECT_EQ(room_a->findTrigger(destroyed), nullptr);
+
+    // Triggers outliving their Room can still unsubscribe
+    triggers[2]->unsubscribe();
+    triggers[2]->subscribe();
+    triggers[2]->unsubscribe();
+}
+
+TEST(TriggersTest, FixedStepContacts){
+    auto room = std::make_shared<mate::Room>();
+    auto game = mate::Game::getGame(400, 400, "", room);
+    game->setFixedStep(sf::milliseconds(10));
+    game->setMaxTicksPerFrame(5);
+
+    for (auto broad_phase : {mate::BRUTE_FORCE, mate::DYNAMIC_TREE})
+    {
+        room->setTriggerBroadPhase(broad_phase);
+        auto element_a = room->addElement();
+        auto element_b = room->addElement();
+        auto trigger_a = element_a->addComponent<mate::EventTrigger>();
+        auto trigger_b = element_b->addComponent<mate::EventTrigger>();
+        trigger_a->setDimensions(10, 10);
+        trigger_b->setDimensions(10, 10);
+        trigger_a->subscribe();
+        trigger_b->subscribe();
+        element_b->setPosition(5, 5);
+
+        // One rendered frame catching up three ticks checks the Triggers on every tick
+        mate::EventTrigger::events.clear();
+        ASSERT_EQ(game->simulate(sf::milliseconds(30)), 3);
+        EXPECT_EQ(mate::EventTrigger::events,
+                  (std::vector<std::string>{"enter", "enter", "stay", "stay", "stay", "stay"}));
+        EXPECT_FALSE(trigger_a->wasChecked());
+
+        // The exit fires on the first tick without the contact, before the frame is rendered
+        mate::EventTrigger::events.clear();
+        element_b->setPosition(50, 50);
+        ASSERT_EQ(game->simulate(sf::milliseconds(20)), 2);
+        EXPECT_EQ(mate::EventTrigger::events, (std::vector<std::string>{"exit", "exit"}));
+
+        element_a->destroy();
+        element_b->destroy();
+        game->simulate(sf::milliseconds(10));
+    }
+    game->setFixedStep(sf::Time::Zero);
+}
+
+namespace mate{
+    // Queries its Room from loop(), before the Elements after it move
+    class QueryComponent : public Component{
+        public:
+        explicit QueryComponent(const std::weak_ptr<Element> &parent) : Component(parent){}
+        std::weak_ptr<Room> room;
+        std::size_t found = 0;
+        void loop() override
+        {
+            std::vector<std::shared_ptr<Trigger>> result;
+            found = room.lock()->queryPoint({50, 50}, result);
+        }
+    };
+
+    class MoveComponent : public Component{
+        public:
+        explicit MoveComponent(const std::weak_ptr<Element> &parent) : Component(parent){}
+        void loop() override
+        {
+            getParentCoords()->setPosition(2, 2);
+        }
+    };
+}
+
+TEST(TriggersTest, QueriesDontChangeContacts){
+    for (auto broad_phase : {mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+    {
+        auto room = std::make_shared<mate::Room>();
+        room->setTriggerBroadPhase(broad_phase);
+        auto query = room->addElement()->addComponent<mate::QueryComponent>();
+        query->room = room;
+
+        // The moving Trigger only reaches the other one on its own loop, after the query
+        auto moving = room->addElement();
+        moving->setPosition(50, 50);
+        moving->addComponent<mate::MoveComponent>();
+        auto trigger_a = moving->addComponent<mate::RecordTrigger>();
+        auto trigger_b = room->addElement()->addComponent<mate::RecordTrigger>();
+        for (const auto &trigger : {trigger_a, trigger_b})
+        {
+            trigger->setDimensions(5, 5);
+            trigger->subscribe();
+        }
+
+        mate::RecordTrigger::fired.clear();
+        room->loop();
+        EXPECT_EQ(query->found, 1);
+        EXPECT_EQ(mate::RecordTrigger::fired.size(), 2);
+
+        // The next query sees the new position
+        room->loop();
+        EXPECT_EQ(query->found, 0);
+    }
+}
+
+namespace mate{
+    // Moves another Element from loop()
+    class PushComponent : public Component{
+        public:
+        explicit PushComponent(const std::weak_ptr<Element> &parent) : Component(parent){}
+        std::weak_ptr<Element> target;
+        sf::Vector2f destination;
+        void loop() override
+        {
+            target.lock()->setPosition(destination);
+        }
+    };
+
+    // Moves its own Element and another one to random positions on every loop()
+    class ShuffleComponent : public Component{
+        public:
+        explicit ShuffleComponent(const std::weak_ptr<Element> &parent) : Component(parent){}
+        std::weak_ptr<Element> target;
+        std::mt19937 generator;
+        void loop() override
+        {
+            std::uniform_real_distribution<float> position(-300, 300);
+            getParentCoords()->setPosition(position(generator), position(generator));
+            target.lock()->setPosition(position(generator), position(generator));
+        }
+    };
+}
+
+TEST(TriggersTest, TriggersMovedMidTick){
+    for (auto broad_phase : {mate::BRUTE_FORCE, mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+    {
+        auto room = std::make_shared<mate::Room>();
+        room->setTriggerBroadPhase(broad_phase);
+
+        // The first Trigger builds the broad-phase before the others move
+        auto far = room->addElement();
+        far->setPosition(500, 500);
+        auto pusher = room->addElement()->addComponent<mate::PushComponent>();
+        auto pushed = room->addElement();
+        pushed->setPosition(100, 100);
+        pusher->target = pushed;
+        pusher->destination = {2, 2};
+        auto still = room->addElement();
+        std::vector<std::shared_ptr<mate::RecordTrigger>> triggers;
+        for (const auto &element : {far, pushed, still})
+        {
+            triggers.push_back(element->addComponent<mate::RecordTrigger>());
+            triggers.back()->setDimensions(5, 5);
+            triggers.back()->subscribe();
+        }
+
+        mate::RecordTrigger::fired.clear();
+        room->loop();
+        EXPECT_EQ(mate::RecordTrigger::fired.size(), 2);
+
+        // Moved away while the pairs of the tick say they are superposed
+        room->loop();
+        pusher->destination = {100, 100};
+        mate::RecordTrigger::fired.clear();
+        room->loop();
+        EXPECT_TRUE(mate::RecordTrigger::fired.empty());
+    }
+}
+
+/**
+ * Runs recordFrames with Elements that move themselves and others while the Room loops.
+ */
+std::vector<std::pair<const mate::Trigger*, const mate::Trigger*>> recordShuffledFrames(
+    const std::shared_ptr<mate::Room> &room, const std::vector<std::shared_ptr<mate::Element>> &elements,
+    const std::vector<std::shared_ptr<mate::ShuffleComponent>> &shufflers)
+{
+    for (std::size_t i = 0; i < shufflers.size(); ++i)
+    {
+        shufflers[i]->generator.seed(i);
+    }
+    return recordFrames(room, elements);
+}
+
+TEST(TriggersTest, ShuffledTriggersMatchBruteForce){
+    for (bool transform_store : {false, true})
+    {
+        auto room = std::make_shared<mate::Room>();
+        if (transform_store)
+        {
+            room->useTransformStore(std::make_shared<mate::TransformStore>());
+        }
+        std::mt19937 generator(5);
+        std::uniform_real_distribution<float> size(10, 80);
+
+        std::vector<std::shared_ptr<mate::Element>> elements;
+        std::vector<std::shared_ptr<mate::ShuffleComponent>> shufflers;
+        for (int i = 0; i < 200; ++i)
+        {
+            auto element = room->addElement();
+            // Moved before and after their own checks
+            if (i % 4 == 1)
+            {
+                shufflers.push_back(element->addComponent<mate::ShuffleComponent>());
+            }
+            auto trigger = element->addComponent<mate::RecordTrigger>();
+            trigger->setDimensions(size(generator), size(generator));
+            trigger->setShape(i % 3 == 0 ? mate::ShapeType::CIRCLE : mate::ShapeType::RECTANGLE);
+            trigger->subscribe();
+            if (i % 4 == 3)
+            {
+                shufflers.push_back(element->addComponent<mate::ShuffleComponent>());
+            }
+            elements.push_back(element);
+        }
+        for (std::size_t i = 0; i < shufflers.size(); ++i)
+        {
+            shufflers[i]->target = elements[(i * 37 + 11) % elements.size()];
+        }
+
+        room->setTriggerBroadPhase(mate::BroadPhaseType::BRUTE_FORCE);
+        auto brute_force = recordShuffledFrames(room, elements, shufflers);
+        ASSERT_FALSE(brute_force.empty());
+
+        for (auto broad_phase : {mate::SPATIAL_HASH, mate::DYNAMIC_TREE, mate::SWEEP_AND_PRUNE})
+        {
+            room->setTriggerBroadPhase(broad_phase);
+            EXPECT_EQ(recordShuffledFrames(room, elements, shufflers), brute_force);
+        }
+    }
+}